@@ -23,6 +23,8 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "system.h"
+#include "lockprof.h"
+#include "freelist.h"
 
 // String definitions for debugging messages
 
@@ -30,6 +32,9 @@ static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
 			"console read", "network send", "network recv"};
 
+static FreeList pendingInterrupts(sizeof(PendingInterrupt));
+				// recycled PendingInterrupts
+
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
 // 	Initialize a hardware device interrupt that is to be scheduled 
@@ -48,6 +53,240 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
     arg = param;
     when = time;
     type = kind;
+    order = 0;
+    cancelled = FALSE;
+}
+
+//----------------------------------------------------------------------
+// PendingInterrupt::operator new, PendingInterrupt::operator delete
+// 	Allocate and de-allocate pending interrupts from their free
+//	list, rather than the heap.
+//----------------------------------------------------------------------
+
+void *
+PendingInterrupt::operator new(size_t size)
+{
+    ASSERT(size == sizeof(PendingInterrupt));
+    return pendingInterrupts.Alloc();
+}
+
+void
+PendingInterrupt::operator delete(void *toOccur)
+{
+    pendingInterrupts.Free(toOccur);
+}
+
+//----------------------------------------------------------------------
+// Earlier
+// 	Return TRUE if interrupt "a" is to fire before interrupt "b":
+//	it is due sooner, or due at the same time and scheduled first.
+//----------------------------------------------------------------------
+
+static bool
+Earlier(PendingInterrupt *a, PendingInterrupt *b)
+{
+    if (a->when != b->when)
+	return (a->when < b->when);
+    return (a->order < b->order);
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::PendingQueue
+// 	Initialize an empty queue of pending interrupts.  The heap starts
+//	small, and grows as needed; normally there is just one pending
+//	interrupt per device.
+//----------------------------------------------------------------------
+
+PendingQueue::PendingQueue()
+{
+    maxPending = 8;
+    heap = new PendingInterrupt *[maxPending];
+    numPending = 0;
+    numCancelled = 0;
+    nextOrder = 0;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::~PendingQueue
+// 	De-allocate the queue, and any interrupts still on it.
+//----------------------------------------------------------------------
+
+PendingQueue::~PendingQueue()
+{
+    int i;
+
+    for (i = 0; i < numPending; i++)
+	delete heap[i];
+    delete [] heap;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Insert
+// 	Put an interrupt on the queue, after any others due at the
+//	same time.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Insert(PendingInterrupt *toOccur)
+{
+    PendingInterrupt **bigger;
+    int i;
+
+    if (numPending == maxPending) {	// out of room; double the heap
+	bigger = new PendingInterrupt *[maxPending * 2];
+	for (i = 0; i < numPending; i++)
+	    bigger[i] = heap[i];
+	delete [] heap;
+	heap = bigger;
+	maxPending *= 2;
+    }
+    toOccur->order = nextOrder++;
+    toOccur->cancelled = FALSE;
+    heap[numPending] = toOccur;
+    SiftUp(numPending++);
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Remove
+// 	Take the next interrupt due off the queue, and return it.
+//	The caller is responsible for de-allocating it.
+//----------------------------------------------------------------------
+
+PendingInterrupt *
+PendingQueue::Remove()
+{
+    PendingInterrupt *front = Front();
+
+    ASSERT(front != NULL);
+    Pop();
+    DropCancelled();
+    return front;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Cancel
+// 	Make sure an interrupt on the queue never fires.  It stays where
+//	it is until it reaches the front, when it is thrown away, so
+//	this is constant time.  "toCancel" must not be used afterwards.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Cancel(PendingInterrupt *toCancel)
+{
+    ASSERT(!toCancel->cancelled);
+    toCancel->cancelled = TRUE;
+    numCancelled++;
+    DropCancelled();			// in case it was the front
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Pop
+// 	Remove heap[0] from the heap: move the last entry into its
+//	place, and let it sink down to where it belongs.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Pop()
+{
+    numPending--;
+    if (numPending > 0) {
+	heap[0] = heap[numPending];
+	SiftDown(0);
+    }
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::DropCancelled
+// 	Throw away cancelled interrupts at the front of the queue, so
+//	that Front never has to look past them.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::DropCancelled()
+{
+    PendingInterrupt *dead;
+
+    while (numPending > 0 && heap[0]->cancelled) {
+	dead = heap[0];
+	Pop();
+	numCancelled--;
+	delete dead;
+    }
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::SiftUp
+// 	Move heap[i] up towards the root, until it is no earlier than
+//	its parent.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::SiftUp(int i)
+{
+    PendingInterrupt *item = heap[i];
+    int parent;
+
+    while (i > 0) {
+	parent = (i - 1) / 2;
+	if (!Earlier(item, heap[parent]))
+	    break;
+	heap[i] = heap[parent];
+	i = parent;
+    }
+    heap[i] = item;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::SiftDown
+// 	Move heap[i] down away from the root, until it is no later than
+//	either of its children.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::SiftDown(int i)
+{
+    PendingInterrupt *item = heap[i];
+    int child;
+
+    for (;;) {
+	child = 2 * i + 1;
+	if (child >= numPending)
+	    break;
+	if (child + 1 < numPending && Earlier(heap[child + 1], heap[child]))
+	    child++;			// the earlier of the two children
+	if (!Earlier(heap[child], item))
+	    break;
+	heap[i] = heap[child];
+	i = child;
+    }
+    heap[i] = item;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Mapcar
+// 	Apply "func" to every interrupt that is still to fire, in the
+//	order they will fire.  Only used for debugging, so it's ok to
+//	insertion sort a copy of the heap each time.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Mapcar(VoidFunctionPtr func)
+{
+    PendingInterrupt **sorted = new PendingInterrupt *[maxPending];
+    PendingInterrupt *item;
+    int i, j, n = 0;
+
+    for (i = 0; i < numPending; i++) {
+	item = heap[i];
+	if (item->cancelled)
+	    continue;
+	for (j = n++; j > 0 && Earlier(item, sorted[j - 1]); j--)
+	    sorted[j] = sorted[j - 1];
+	sorted[j] = item;
+    }
+    for (i = 0; i < n; i++)
+	(*func)((int) sorted[i]);
+    delete [] sorted;
 }
 
 //----------------------------------------------------------------------
@@ -60,7 +299,7 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    pending = new PendingQueue();
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -73,8 +312,6 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty())
-	delete (PendingInterrupt *)pending->Remove();
     delete pending;
 }
 
@@ -169,15 +406,52 @@ Interrupt::OneTick()
     while (CheckIfDue(FALSE))		// check for pending interrupts
 	;
     ChangeLevel(IntOff, IntOn);		// re-enable interrupts
-    if (yieldOnReturn) {		// if the timer device handler asked 
-					// for a context switch, ok to do it now
+    if (yieldOnReturn) {		// if the timer device handler (or the
+					// kernel) asked for a context switch,
+					// ok to do it now
 	yieldOnReturn = FALSE;
  	status = SystemMode;		// yield is a kernel routine
-	currentThread->Yield();
+	scheduler->Preempt();
 	status = old;
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::TicksUntilNextInterrupt
+// 	Return how much simulated time can pass before the next pending
+//	interrupt is due, or a very large number if nothing is pending.
+//----------------------------------------------------------------------
+int
+Interrupt::TicksUntilNextInterrupt()
+{
+    if (pending->IsEmpty())
+	return 0x7fffffff;
+    return pending->Front()->when - stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::AdvanceTicks
+// 	Advance simulated time by "ticks", exactly as that many calls
+//	to OneTick would, when the caller knows that no interrupt can
+//	become due in the meantime (ticks < TicksUntilNextInterrupt()).
+//	Used by Machine::Run, which only does the full interrupt
+//	bookkeeping when an interrupt might be due, and by the JIT, which
+//	runs a whole block of user instructions before accounting for them.
+//
+//	Unlike OneTick, this doesn't print the "-d i" trace; the machine
+//	falls back to calling OneTick every instruction when it is on.
+//----------------------------------------------------------------------
+void
+Interrupt::AdvanceTicks(int ticks)
+{
+    ASSERT(ticks < TicksUntilNextInterrupt());
+    stats->totalTicks += ticks;
+    if (status == SystemMode)
+	stats->systemTicks += ticks;
+    else
+	stats->userTicks += ticks;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	Called from within an interrupt handler, to cause a context switch
@@ -187,12 +461,17 @@ Interrupt::OneTick()
 //	We can't do the context switch here, because that would switch
 //	out the interrupt handler, and we want to switch out the 
 //	interrupted thread.
+//
+//	Also called by the kernel with interrupts disabled (when a thread
+//	it wakes should preempt it), to switch once it enables them again,
+//	and so has finished whatever it disabled them for.  If the thread
+//	switches away before then anyway, Scheduler::Run calls CancelYield.
 //----------------------------------------------------------------------
 
 void
 Interrupt::YieldOnReturn()
 { 
-    ASSERT(inHandler == TRUE);  
+    ASSERT(level == IntOff);  
     yieldOnReturn = TRUE; 
 }
 
@@ -242,6 +521,19 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+#ifdef USER_PROGRAM
+    frameTable->Print();
+#endif
+#ifdef VM
+    pager->Print();
+#endif
+#ifdef USE_TLB
+    tlbManager->Print();
+#endif
+    ThreadStats::FinishDump();
+#ifdef LOCK_PROFILE
+    SynchProfile::PrintAll();
+#endif
     Cleanup();     // Never returns.
 }
 
@@ -250,18 +542,21 @@ Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: just put it on the heap of pending interrupts.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
 //
+//	Returns the pending interrupt, in case the device wants to
+//	Cancel it; it is de-allocated once it has fired.
+//
 //	"handler" is the procedure to call when the interrupt occurs
 //	"arg" is the argument to pass to the procedure
 //	"fromNow" is how far in the future (in simulated time) the 
 //		 interrupt is to occur
 //	"type" is the hardware device that generated the interrupt
 //----------------------------------------------------------------------
-void
+PendingInterrupt *
 Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 {
     int when = stats->totalTicks + fromNow;
@@ -271,7 +566,24 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending->Insert(toOccur);
+    return toOccur;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Arrange for an interrupt returned by Schedule never to occur.
+//	It must not have fired yet.
+//
+//	NOTE: like Schedule, only called by the hardware device
+//	simulators.
+//----------------------------------------------------------------------
+void
+Interrupt::Cancel(PendingInterrupt *toCancel)
+{
+    DEBUG('i', "Cancelling interrupt handler the %s at time = %d\n", 
+				intTypeNames[toCancel->type], toCancel->when);
+    pending->Cancel(toCancel);
 }
 
 //----------------------------------------------------------------------
@@ -291,32 +603,31 @@ bool
 Interrupt::CheckIfDue(bool advanceClock)
 {
     MachineStatus old = status;
+    PendingInterrupt *toOccur = pending->Front();
     int when;
 
     ASSERT(level == IntOff);		// interrupts need to be disabled,
 					// to invoke an interrupt handler
     if (DebugIsEnabled('i'))
 	DumpState();
-    PendingInterrupt *toOccur = 
-		(PendingInterrupt *)pending->SortedRemove(&when);
-
     if (toOccur == NULL)		// no pending interrupts
 	return FALSE;			
+    when = toOccur->when;
+    if (!advanceClock && when > stats->totalTicks)
+	return FALSE;			// not time yet; just peek, leaving
+					// the queue alone
 
     if (advanceClock && when > stats->totalTicks) {	// advance the clock
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
-	return FALSE;
     }
 
 // Check if there is nothing more to do, and if so, quit
     if ((status == IdleMode) && (toOccur->type == TimerInt) 
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
-	 return FALSE;
-    }
+				&& pending->NumPending() == 1)
+	 return FALSE;			// leave the timer where it is
+
+    (void) pending->Remove();
 
     DEBUG('i', "Invoking interrupt handler for the %s at time %d\n", 
 			intTypeNames[toOccur->type], toOccur->when);
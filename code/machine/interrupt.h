@@ -62,11 +62,61 @@ class PendingInterrupt {
 				// initialize an interrupt that will
 				// occur in the future
 
+    void *operator new(size_t size);	// allocated from a free list,
+    void operator delete(void *toOccur); // since there's one per time slice
+
     VoidFunctionPtr handler;    // The function (in the hardware device
 				// emulator) to call when the interrupt occurs
     int arg;                    // The argument to the function.
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+
+    unsigned int order;		// when it was scheduled, relative to the
+				// others; breaks ties in "when", so that
+				// interrupts due at the same time fire
+				// in the order they were scheduled
+    bool cancelled;		// TRUE if it should never fire
+};
+
+// The interrupts scheduled to occur in the future, kept as a binary
+// min-heap ordered by "when" (then "order"), so that scheduling and
+// firing an interrupt are O(log n), and looking at the next one due
+// is O(1) and changes nothing.
+//
+// Cancelling is O(1): the interrupt is just marked, and thrown away
+// when it reaches the front.  The front is never a cancelled interrupt.
+
+class PendingQueue {
+  public:
+    PendingQueue();			// initialize an empty queue
+    ~PendingQueue();			// de-allocate the queue, and
+					// anything still on it
+
+    bool IsEmpty() { return (numPending == 0); }
+    PendingInterrupt *Front() 		// the next one due, NULL if none
+	{ return (numPending == 0) ? NULL : heap[0]; }
+    int NumPending() { return numPending - numCancelled; }
+
+    void Insert(PendingInterrupt *toOccur); // add an interrupt
+    PendingInterrupt *Remove();		// take off the next one due
+    void Cancel(PendingInterrupt *toCancel); // make sure it never fires;
+					// the queue de-allocates it
+
+    void Mapcar(VoidFunctionPtr func);	// apply "func" to every interrupt
+					// still to fire, in time order
+
+  private:
+    PendingInterrupt **heap;		// heap[0] is due first; the children
+					// of heap[i] are heap[2i+1], heap[2i+2]
+    int numPending;			// entries in use, cancelled or not
+    int numCancelled;			// entries in use that are cancelled
+    int maxPending;			// size of "heap"
+    unsigned int nextOrder;		// "order" for the next Insert
+
+    void Pop();				// remove heap[0]
+    void DropCancelled();		// Pop cancelled entries off the front
+    void SiftUp(int i);			// restore the heap property, after
+    void SiftDown(int i);		// heap[i] got earlier or later
 };
 
 // The following class defines the data structures for the simulation
@@ -93,9 +143,14 @@ class Interrupt {
     void Halt(); 			// quit and print out stats
     
     void YieldOnReturn();		// cause a context switch on return 
-					// from an interrupt handler
+					// from an interrupt handler, or when
+					// interrupts are next enabled
+    void CancelYield() { yieldOnReturn = FALSE; } // the thread switched
+					// away already
 
     MachineStatus getStatus() { return status; } // idle, kernel, user
+    bool isInHandler() { return inHandler; } // TRUE while running an
+					// interrupt handler
     void setStatus(MachineStatus st) { status = st; }
 
     void DumpState();			// Print interrupt state
@@ -106,16 +161,25 @@ class Interrupt {
     // but they need to be public since they are called by the
     // hardware device simulators.
 
-    void Schedule(VoidFunctionPtr handler,// Schedule an interrupt to occur
-	int arg, int when, IntType type);// at time ``when''.  This is called
-    					// by the hardware device simulators.
+    PendingInterrupt *Schedule(VoidFunctionPtr handler,// Schedule an 
+	int arg, int when, IntType type);// interrupt to occur at time 
+    					// ``when''.  This is called by the
+    					// hardware device simulators.
+    void Cancel(PendingInterrupt *toCancel); // Un-schedule an interrupt
+					// that has not fired yet
     
     void OneTick();       		// Advance simulated time
 
+    int TicksUntilNextInterrupt();	// Time left before the next pending
+					// interrupt is due
+    void AdvanceTicks(int ticks);	// Advance simulated time by several
+					// ticks, when no interrupt can be
+					// due in the meantime
+
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
-				// to occur in the future
+    PendingQueue *pending;	// the interrupts scheduled to occur
+				// in the future
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
@@ -9,6 +9,8 @@
 
 #include "copyright.h"
 #include "machine.h"
+#include "mipsblock.h"
+#include "mipsjit.h"
 #include "system.h"
 
 // Textual names of the exceptions that can be generated by user program
@@ -50,9 +52,15 @@ void CheckEndian()
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"engineType" -- execute user code one instruction at a time,
+//		with the basic-block threaded interpreter, or with the
+//		interpreter plus the JIT.
+//	"tlbEntries" -- the size of the TLB, if there is one
+//	"tlbAssoc" -- its associativity: the entries in each set
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, ExecEngine engineType, int tlbEntries,
+		 int tlbAssoc)
 {
 	int i;
 
@@ -61,15 +69,36 @@ Machine::Machine(bool debug)
 	mainMemory = new char[MemorySize];
 	for (i = 0; i < MemorySize; i++)
 		mainMemory[i] = 0;
+	decodeCache = new Instruction[MemorySize / sizeof(int)];
+	decodeValid = new bool[MemorySize / sizeof(int)];
+	decodeGeneration = 0;
+	for (i = 0; i < NumPhysPages; i++)
+		frameGeneration[i] = 0;
+	FlushDecodeCache();
+	FlushSoftTLB();
+	engine = engineType;
+	blockCache = NULL;
+	jit = NULL;
+	trapped = FALSE;
 #ifdef USE_TLB
-	tlb = new TranslationEntry[TLBSize];
-	for (i = 0; i < TLBSize; i++)
+	ASSERT(tlbEntries > 0 && tlbAssoc > 0 && tlbEntries % tlbAssoc == 0);
+	tlbSize = tlbEntries;
+	tlbWays = tlbAssoc;
+	tlb = new TranslationEntry[tlbSize];
+	tlbLastUse = new unsigned int[tlbSize];
+	for (i = 0; i < tlbSize; i++) {
 		tlb[i].valid = FALSE;
+		tlb[i].asid = -1;
+		tlbLastUse[i] = 0;
+	}
 	pageTable = NULL;
 #else	// use linear page table
 	tlb = NULL;
+	tlbSize = tlbWays = 0;
+	tlbLastUse = NULL;
 	pageTable = NULL;
 #endif
+	currentAsid = 0;
 
 	singleStep = debug;
 	CheckEndian();
@@ -83,8 +112,16 @@ Machine::Machine(bool debug)
 Machine::~Machine()
 {
 	delete [] mainMemory;
-	if (tlb != NULL)
+	delete [] decodeCache;
+	delete [] decodeValid;
+	if (blockCache != NULL)
+		delete [] blockCache;
+	if (jit != NULL)
+		delete jit;
+	if (tlb != NULL) {
 		delete [] tlb;
+		delete [] tlbLastUse;
+	}
 }
 
 //----------------------------------------------------------------------
@@ -104,12 +141,10 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
 
 	//  ASSERT(interrupt->getStatus() == UserMode);
 	registers[BadVAddrReg] = badVAddr;
+	trapped = TRUE;
 	DelayedLoad(0, 0);			// finish anything in progress
 	interrupt->setStatus(SystemMode);
 
-	registers[PrevPCReg] = registers[PCReg];
-	registers[PCReg] += sizeof(int);
-	registers[NextPCReg] += registers[PCReg] + sizeof(int);
 	ExceptionHandler(which);		// interrupts are enabled at this point
 
 	interrupt->setStatus(UserMode);
@@ -35,6 +35,11 @@
 #define NumPhysPages    32
 #define MemorySize 	(NumPhysPages * PageSize)
 #define TLBSize		4		// if there is a TLB, make it small
+					// (the default; see -tlb)
+#define NumAsids	64		// address space ids a TLB entry
+					// can be tagged with
+#define SoftTLBSize	64		// translations cached by the
+					// simulator (see translate.h)
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -57,6 +62,16 @@ enum ExceptionType { NoException,           // Everything ok!
 // any two instructions (thus we need to keep track of things like load
 // delay slots, etc.)
 
+// The simulator can execute user code with any of three engines,
+// chosen on the command line.  All produce the same results and
+// exactly the same simulated timing.
+
+enum ExecEngine { InterpEngine,		// one instruction at a time
+		  BlockEngine,		// basic-block threaded interpreter
+		  JitEngine		// BlockEngine, plus translation of
+					// hot blocks into host code
+};
+
 #define StackReg	29	// User's stack pointer
 #define RetAddrReg	31	// Holds return address for procedure calls
 #define NumGPRegs	32	// 32 general purpose registers on MIPS
@@ -91,6 +106,9 @@ class Instruction {
                      // Immediates are sign-extended.
 };
 
+class Block;
+class JitCompiler;
+
 // The following class defines the simulated host workstation hardware, as 
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our 
@@ -106,8 +124,11 @@ class Instruction {
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
-				// for running user programs
+    Machine(bool debug, ExecEngine engineType, int tlbEntries = TLBSize,
+	    int tlbAssoc = TLBSize);
+				// Initialize the simulation of the hardware
+				// for running user programs; with a TLB
+				// of "tlbEntries", in sets of "tlbAssoc"
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -123,6 +144,8 @@ class Machine {
 
     void OneInstruction(Instruction *instr); 	
     				// Run one instruction of a user program.
+    void RunBlocks();		// Run a user program on the basic-block
+				// threaded interpreter; never returns
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
     
@@ -131,6 +154,18 @@ class Machine {
     				// Read or write 1, 2, or 4 bytes of virtual 
 				// memory (at addr).  Return FALSE if a 
 				// correct translation couldn't be found.
+
+    bool CopyFromUser(int userAddr, char *buf, int size);
+    bool CopyToUser(int userAddr, char *buf, int size);
+				// Copy "size" bytes between virtual memory
+				// and a kernel buffer, a page at a time,
+				// for system calls.  Return FALSE if some
+				// page couldn't be translated.
+    int CopyStringFromUser(int userAddr, char *buf, int maxLength);
+				// Copy a null-terminated string of at most
+				// "maxLength" bytes (counting the null);
+				// return its length, or -1 if it couldn't
+				// be translated or was too long.
     
     ExceptionType Translate(int virtAddr, int* physAddr, int size,bool writing);
     				// Translate an address, and check for 
@@ -146,6 +181,17 @@ class Machine {
     void Debugger();		// invoke the user program debugger
     void DumpState();		// print the user CPU and memory state 
 
+    void FlushDecodeCache();	// forget every pre-decoded instruction;
+				// called when the page table changes
+    void InvalidateDecodeCache(int frame);
+				// forget the pre-decoded instructions
+				// in one physical page frame
+    void FlushSoftTLB();	// forget every cached translation; called
+				// when the page table changes
+    int TLBSet(unsigned int vpn, int asid);
+				// the first TLB entry of the set that
+				// "vpn" of "asid" may be cached in
+
 
 // Data structures -- all of these are accessible to Nachos kernel code.
 // "public" for convenience.
@@ -175,14 +221,76 @@ class Machine {
 // space, stored in memory), there is only one TLB (implemented in hardware).
 // Thus the TLB pointer should be considered as *read-only*, although 
 // the contents of the TLB are free to be modified by the kernel software.
+//
+// The TLB has "tlbSize" entries, in sets of "tlbWays" (so it is fully
+// associative if they are equal).  A page may only be cached in the set
+// that TLBSet picks for it, by hashing its page number and address space
+// id; the kernel picks which entry of the set to replace.  Each entry is
+// tagged with an address space id (asid), and only matches while
+// "currentAsid" is the same, so the kernel needn't flush the TLB when it
+// switches address spaces.
+//
+// With a page table, after changing (or switching) it, other than just
+// clearing use and dirty bits, the kernel must call FlushSoftTLB.  The
+// soft TLB isn't used with a TLB, so that the TLB sees every reference.
+// The block engines (-bb, -jit) only translate the PC at the start of a
+// basic block, but count the fetches of the rest of its instructions
+// as TLB hits afterwards (see CountBlockFetches), so the hit rate is
+// per instruction, and comparable, whichever engine runs.
 
     TranslationEntry *tlb;		// this pointer should be considered 
 					// "read-only" to Nachos kernel code
+    int tlbSize;			// entries in the TLB
+    int tlbWays;			// entries in each set
+    unsigned int *tlbLastUse;		// when each entry was last matched,
+					// counting TLB hits, for LRU
+    int currentAsid;			// the address space id the TLB
+					// matches entries of
 
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
 
+    int jitValue;		// value returned by a load made from code
+				// translated by the JIT (see mipsjit.cc)
+
   private:
+    friend class JitCompiler;	// translated code keeps the decoded-
+				// instruction cache up to date too
+
+    Instruction *decodeCache;	// pre-decoded instructions, one per word
+				// of physical memory, so that re-executing
+				// user text skips the fetch and Decode()
+    bool *decodeValid;		// is decodeCache[i] up to date?
+    bool frameDecoded[NumPhysPages]; // does this frame hold any valid
+				// entry of decodeCache?
+    unsigned int decodeGeneration; // bumped by FlushDecodeCache
+    unsigned int frameGeneration[NumPhysPages]; // bumped when a frame is
+				// invalidated by InvalidateDecodeCache
+
+    SoftTLBEntry softTlb[SoftTLBSize]; // recent translations, direct-
+				// mapped by virtual page number
+
+    ExecEngine engine;		// which engine Run() should use
+    Block *blockCache;		// compiled basic blocks, for BlockEngine
+				// and JitEngine
+    JitCompiler *jit;		// translator into host code, for JitEngine
+    Block *FindBlock(void **handlers);
+				// find (or compile) the block starting at
+				// the PC, NULL if it can't be run as a block
+    void CountBlockFetches(unsigned int vpn, int asid, int fetches);
+				// count the fetches of a block's
+				// instructions after the first as TLB hits
+
+    ExceptionType TranslateForCopy(int virtAddr, int *physAddr,
+				   bool writing);
+				// Translate, for the Copy routines: a
+				// page fault is handled, as if the kernel
+				// had touched the page, and retried
+    bool trapped;		// set by RaiseException, so that Run knows
+				// the kernel ran in the middle of a batch
+    int QuietSteps();		// how many more instructions can finish
+				// before one of them needs a full OneTick
+
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
@@ -0,0 +1,698 @@
+// mipsblock.cc -- basic-block threaded interpreter for the MIPS simulator
+//
+//   Machine::Run normally fetches, decodes and dispatches every user
+//   instruction through the switch in Machine::OneInstruction.  With
+//   "-bb", Run instead calls RunBlocks, which compiles each basic block
+//   once into an array of ops (see mipsblock.h) and then executes the
+//   block by jumping directly from the code for one op to the code for
+//   the next (direct threading, using gcc's labels-as-values).
+//
+//   Simulated behavior is identical to OneInstruction: every op still
+//   applies the pending delayed load, advances the PCs, and then calls
+//   interrupt->OneTick(), so userTicks and the delivery of interrupts
+//   are exactly the same.  We leave a block (and look up the next one)
+//   whenever an exception is raised, or when OneTick may have switched
+//   to another address space or something has written into the code.
+//
+//   DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#include "machine.h"
+#include "mipssim.h"
+#include "mipsblock.h"
+#include "mipsjit.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// EndsBlock
+// 	Return TRUE if a basic block must end after this instruction:
+//	branches and jumps (after their delay slot, see CompileBlock),
+//	and anything that always traps to the kernel.
+//----------------------------------------------------------------------
+
+static bool
+IsBranch(int opCode)
+{
+    switch (opCode) {
+      case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+      case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+      case OP_J: case OP_JAL: case OP_JALR: case OP_JR:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+static bool
+EndsBlock(int opCode)
+{
+    switch (opCode) {
+      case OP_SYSCALL: case OP_RES: case OP_UNIMP: case OP_RFE:
+	return TRUE;
+      default:
+	return IsBranch(opCode);
+    }
+}
+
+//----------------------------------------------------------------------
+// CompileBlock
+// 	Decode the basic block starting at physical address "physAddr"
+//	into "block".  The block stops at the end of the physical page
+//	(the next virtual page may map anywhere), after MaxBlockOps
+//	instructions, after a trapping instruction, or one instruction
+//	after a branch (so that the delay slot is part of the block).
+//
+//	"handlers" maps each opcode to the code that executes it.
+//----------------------------------------------------------------------
+
+static void
+CompileBlock(Block *block, char *memory, int physAddr, void **handlers)
+{
+    int addr = physAddr;
+    int pageEnd = (physAddr / PageSize + 1) * PageSize;
+    bool inDelaySlot = FALSE;
+    Instruction *instr;
+
+    block->physAddr = physAddr;
+    block->numOps = 0;
+    block->runCount = 0;
+    block->native = NULL;
+    while (addr < pageEnd && block->numOps < MaxBlockOps) {
+	instr = &block->ops[block->numOps].instr;
+	instr->value = WordToHost(*(unsigned int *) &memory[addr]);
+	instr->Decode();
+	ASSERT(instr->opCode <= MaxOpcode);
+	block->ops[block->numOps].handler = handlers[(int) instr->opCode];
+	block->numOps++;
+	addr += 4;
+
+	if (inDelaySlot || EndsBlock(instr->opCode)) {
+	    if (inDelaySlot || !IsBranch(instr->opCode))
+		break;
+	    inDelaySlot = TRUE;		// take the delay slot, then stop
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::FindBlock
+// 	Return the compiled block starting at the current PC, compiling
+//	it if it isn't in the block cache.
+//
+//	Returns NULL if the next instruction can't start a block: if
+//	it is in a branch delay slot (the instruction after it is not
+//	PC + 4), or if the PC can't be translated (OneInstruction will
+//	raise the exception for us).
+//
+//	"handlers" maps each opcode to the code that executes it.
+//----------------------------------------------------------------------
+
+Block *
+Machine::FindBlock(void **handlers)
+{
+    int physAddr;
+    Block *block;
+
+    if (registers[NextPCReg] != registers[PCReg] + 4)
+	return NULL;
+    if (Translate(registers[PCReg], &physAddr, 4, FALSE) != NoException)
+	return NULL;
+
+    block = &blockCache[(physAddr / sizeof(int)) % BlockCacheSize];
+    if (block->physAddr == physAddr && block->generation == decodeGeneration
+	    && block->frameGeneration == frameGeneration[physAddr / PageSize])
+	return block;
+
+    CompileBlock(block, mainMemory, physAddr, handlers);
+    block->generation = decodeGeneration;
+    block->frameGeneration = frameGeneration[physAddr / PageSize];
+    frameDecoded[physAddr / PageSize] = TRUE;	// so WriteMem tells us
+						// if the code changes
+    return block;
+}
+
+// Retire the op that just executed, exactly as OneInstruction and Run
+// would: apply the delayed load, advance the program counters, and
+// advance simulated time (just counting the tick, as Run does, until
+// an interrupt might be due).  Then, unless the block is done or has
+// been invalidated (by OneTick switching threads, or by a store into
+// its page), go straight to the next op.
+
+#define RETIRE(loadReg, loadValue, nextPC)				\
+    {									\
+	pcAfter = (nextPC);						\
+	registers[registers[LoadReg]] = registers[LoadValueReg];	\
+	registers[LoadReg] = (loadReg);					\
+	registers[LoadValueReg] = (loadValue);				\
+	registers[0] = 0;						\
+	registers[PrevPCReg] = registers[PCReg];			\
+	registers[PCReg] = registers[NextPCReg];			\
+	registers[NextPCReg] = pcAfter;					\
+	if (--quiet > 0)						\
+	    interrupt->AdvanceTicks(UserTick);				\
+	else {								\
+	    interrupt->OneTick();					\
+	    quiet = QuietSteps();					\
+	}								\
+	if (++op == end || generation != decodeGeneration		\
+		|| frameGen != frameGeneration[frame])			\
+	    goto blockDone;						\
+	goto *op->handler;						\
+    }
+
+// The common case: no load, no branch.
+#define NEXT()	RETIRE(0, 0, registers[NextPCReg] + 4)
+
+// A branch to "target" if "cond" holds.
+#define BRANCH(cond)							\
+    RETIRE(0, 0, (cond) ? registers[NextPCReg] + IndexToAddr(I->extra)	\
+			: registers[NextPCReg] + 4)
+
+// An exception was raised by the current op; OneInstruction would have
+// returned to Run, which still calls OneTick.
+#define FAULT()	goto fault
+
+#define I	(&op->instr)
+
+// The op's registers.  The register numbers in an Instruction are chars,
+// so they are widened before being used as subscripts.
+#define RS	registers[(int) I->rs]
+#define RT	registers[(int) I->rt]
+#define RD	registers[(int) I->rd]
+
+//----------------------------------------------------------------------
+// Machine::CountBlockFetches
+// 	With a TLB, count the instruction fetches of a basic block after
+//	the first, which FindBlock translated, as the TLB hits they would
+//	have been, and time-stamp the entry for LRU as the last of them
+//	would have.  If a data reference's refill has replaced the entry
+//	meanwhile, the fetches still count as hits, though the hardware
+//	might have missed on them.
+//
+//	"vpn" is the virtual page the block is on
+//	"asid" is the address space id it ran under
+//	"fetches" is how many of its instructions were fetched
+//----------------------------------------------------------------------
+
+void
+Machine::CountBlockFetches(unsigned int vpn, int asid, int fetches)
+{
+    int set, i;
+
+    if (tlb == NULL || fetches <= 1)
+	return;
+    stats->numTLBHits += fetches - 1;
+    set = TLBSet(vpn, asid);
+    for (i = set; i < set + tlbWays; i++)
+	if (tlb[i].valid && tlb[i].virtualPage == (int) vpn
+					&& tlb[i].asid == asid) {
+	    tlbLastUse[i] = stats->numTLBHits;
+	    return;
+	}
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlocks
+// 	Simulate the execution of a user-level program, a basic block
+//	at a time.  Called by Machine::Run; never returns.
+//
+//	Each label below executes one kind of instruction; the code is
+//	the same as the corresponding case in OneInstruction.
+//
+//	With the JIT, a block that has run often enough is translated
+//	into host code (see mipsjit.cc), which is run instead whenever
+//	the whole block can finish before the next interrupt is due.
+//----------------------------------------------------------------------
+
+void
+Machine::RunBlocks()
+{
+    void *handlers[MaxOpcode + 1];
+    Instruction *instr = new Instruction;  // for the slow path
+    Block *block;
+    BlockOp *op, *end;
+    unsigned int generation, frameGen;
+    int frame, i, done;
+    int quiet;				// see Machine::Run
+    unsigned int blockVpn;		// where the block is, for
+    int blockAsid;			// CountBlockFetches
+    int pcAfter, sum, diff, tmp, value, loadValue;
+    unsigned int rs, rt, imm;
+
+    for (i = 0; i <= MaxOpcode; i++)
+	handlers[i] = &&op_bad;
+    handlers[OP_ADD] = &&op_add;	handlers[OP_ADDI] = &&op_addi;
+    handlers[OP_ADDIU] = &&op_addiu;	handlers[OP_ADDU] = &&op_addu;
+    handlers[OP_AND] = &&op_and;	handlers[OP_ANDI] = &&op_andi;
+    handlers[OP_BEQ] = &&op_beq;	handlers[OP_BGEZ] = &&op_bgez;
+    handlers[OP_BGEZAL] = &&op_bgezal;	handlers[OP_BGTZ] = &&op_bgtz;
+    handlers[OP_BLEZ] = &&op_blez;	handlers[OP_BLTZ] = &&op_bltz;
+    handlers[OP_BLTZAL] = &&op_bltzal;	handlers[OP_BNE] = &&op_bne;
+    handlers[OP_DIV] = &&op_div;	handlers[OP_DIVU] = &&op_divu;
+    handlers[OP_J] = &&op_j;		handlers[OP_JAL] = &&op_jal;
+    handlers[OP_JALR] = &&op_jalr;	handlers[OP_JR] = &&op_jr;
+    handlers[OP_LB] = &&op_lb;		handlers[OP_LBU] = &&op_lbu;
+    handlers[OP_LH] = &&op_lh;		handlers[OP_LHU] = &&op_lhu;
+    handlers[OP_LUI] = &&op_lui;	handlers[OP_LW] = &&op_lw;
+    handlers[OP_LWL] = &&op_lwl;	handlers[OP_LWR] = &&op_lwr;
+    handlers[OP_MFHI] = &&op_mfhi;	handlers[OP_MFLO] = &&op_mflo;
+    handlers[OP_MTHI] = &&op_mthi;	handlers[OP_MTLO] = &&op_mtlo;
+    handlers[OP_MULT] = &&op_mult;	handlers[OP_MULTU] = &&op_multu;
+    handlers[OP_NOR] = &&op_nor;	handlers[OP_OR] = &&op_or;
+    handlers[OP_ORI] = &&op_ori;	handlers[OP_SB] = &&op_sb;
+    handlers[OP_SH] = &&op_sh;		handlers[OP_SLL] = &&op_sll;
+    handlers[OP_SLLV] = &&op_sllv;	handlers[OP_SLT] = &&op_slt;
+    handlers[OP_SLTI] = &&op_slti;	handlers[OP_SLTIU] = &&op_sltiu;
+    handlers[OP_SLTU] = &&op_sltu;	handlers[OP_SRA] = &&op_sra;
+    handlers[OP_SRAV] = &&op_srav;	handlers[OP_SRL] = &&op_srl;
+    handlers[OP_SRLV] = &&op_srlv;	handlers[OP_SUB] = &&op_sub;
+    handlers[OP_SUBU] = &&op_subu;	handlers[OP_SW] = &&op_sw;
+    handlers[OP_SWL] = &&op_swl;	handlers[OP_SWR] = &&op_swr;
+    handlers[OP_SYSCALL] = &&op_syscall; handlers[OP_XOR] = &&op_xor;
+    handlers[OP_XORI] = &&op_xori;	handlers[OP_RES] = &&op_illegal;
+    handlers[OP_UNIMP] = &&op_illegal;
+
+    if (blockCache == NULL) {
+	blockCache = new Block[BlockCacheSize];
+	for (i = 0; i < BlockCacheSize; i++)
+	    blockCache[i].physAddr = -1;
+    }
+    if (engine == JitEngine && jit == NULL)
+	jit = new JitCompiler(this);
+
+    for (;;) {
+	quiet = QuietSteps();
+	block = FindBlock(handlers);
+	if (block == NULL) {		// can't start a block here; take
+	    OneInstruction(instr);	// one step the slow way
+	    interrupt->OneTick();
+	    continue;
+	}
+	blockVpn = (unsigned) registers[PCReg] / PageSize;
+	blockAsid = currentAsid;
+	if (jit != NULL) {		// hot blocks run as host code
+	    if (block->native == NULL
+		    || block->nativeGeneration != jit->generation) {
+		if (++block->runCount >= JitThreshold)
+		    (void) jit->Compile(block);
+	    }
+	    if (block->native != NULL
+		    && block->nativeGeneration == jit->generation
+		    && block->numNative < quiet) {
+		done = ((JitCode) block->native)(registers);
+		CountBlockFetches(blockVpn, blockAsid, done);
+		interrupt->AdvanceTicks(done * UserTick);
+		if (done < block->numNative) {	// it stopped short, at
+		    OneInstruction(instr);	// an op that needs the
+		    interrupt->OneTick();	// slow way
+		}
+		continue;
+	    }
+	}
+	generation = block->generation;
+	frame = block->physAddr / PageSize;
+	frameGen = block->frameGeneration;
+	op = block->ops;
+	end = op + block->numOps;
+	goto *op->handler;
+
+      op_add:
+	sum = RS + RT;
+	if (!((RS ^ RT) & SIGN_BIT) &&
+	    ((RS ^ sum) & SIGN_BIT)) {
+	    RaiseException(OverflowException, 0);
+	    FAULT();
+	}
+	RD = sum;
+	NEXT();
+
+      op_addi:
+	sum = RS + I->extra;
+	if (!((RS ^ I->extra) & SIGN_BIT) &&
+	    ((I->extra ^ sum) & SIGN_BIT)) {
+	    RaiseException(OverflowException, 0);
+	    FAULT();
+	}
+	RT = sum;
+	NEXT();
+
+      op_addiu:
+	RT = RS + I->extra;
+	NEXT();
+
+      op_addu:
+	RD = RS + RT;
+	NEXT();
+
+      op_and:
+	RD = RS & RT;
+	NEXT();
+
+      op_andi:
+	RT = RS & (I->extra & 0xffff);
+	NEXT();
+
+      op_beq:
+	BRANCH(RS == RT);
+
+      op_bgezal:
+	registers[R31] = registers[NextPCReg] + 4;
+      op_bgez:
+	BRANCH(!(RS & SIGN_BIT));
+
+      op_bgtz:
+	BRANCH(RS > 0);
+
+      op_blez:
+	BRANCH(RS <= 0);
+
+      op_bltzal:
+	registers[R31] = registers[NextPCReg] + 4;
+      op_bltz:
+	BRANCH(RS & SIGN_BIT);
+
+      op_bne:
+	BRANCH(RS != RT);
+
+      op_div:
+	if (RT == 0) {
+	    registers[LoReg] = 0;
+	    registers[HiReg] = 0;
+	} else {
+	    registers[LoReg] =  RS / RT;
+	    registers[HiReg] = RS % RT;
+	}
+	NEXT();
+
+      op_divu:
+	rs = (unsigned int) RS;
+	rt = (unsigned int) RT;
+	if (rt == 0) {
+	    registers[LoReg] = 0;
+	    registers[HiReg] = 0;
+	} else {
+	    tmp = rs / rt;
+	    registers[LoReg] = (int) tmp;
+	    tmp = rs % rt;
+	    registers[HiReg] = (int) tmp;
+	}
+	NEXT();
+
+      op_jal:
+	registers[R31] = registers[NextPCReg] + 4;
+      op_j:
+	RETIRE(0, 0, ((registers[NextPCReg] + 4) & 0xf0000000)
+			| IndexToAddr(I->extra));
+
+      op_jalr:
+	RD = registers[NextPCReg] + 4;
+      op_jr:
+	RETIRE(0, 0, RS);
+
+      op_lb:
+      op_lbu:
+	tmp = RS + I->extra;
+	if (!ReadMem(tmp, 1, &value))
+	    FAULT();
+	if ((value & 0x80) && (I->opCode == OP_LB))
+	    value |= 0xffffff00;
+	else
+	    value &= 0xff;
+	RETIRE(I->rt, value, registers[NextPCReg] + 4);
+
+      op_lh:
+      op_lhu:
+	tmp = RS + I->extra;
+	if (tmp & 0x1) {
+	    RaiseException(AddressErrorException, tmp);
+	    FAULT();
+	}
+	if (!ReadMem(tmp, 2, &value))
+	    FAULT();
+	if ((value & 0x8000) && (I->opCode == OP_LH))
+	    value |= 0xffff0000;
+	else
+	    value &= 0xffff;
+	RETIRE(I->rt, value, registers[NextPCReg] + 4);
+
+      op_lui:
+	RT = I->extra << 16;
+	NEXT();
+
+      op_lw:
+	tmp = RS + I->extra;
+	if (tmp & 0x3) {
+	    RaiseException(AddressErrorException, tmp);
+	    FAULT();
+	}
+	if (!ReadMem(tmp, 4, &value))
+	    FAULT();
+	RETIRE(I->rt, value, registers[NextPCReg] + 4);
+
+      op_lwl:
+	tmp = RS + I->extra;
+	ASSERT((tmp & 0x3) == 0);
+	if (!ReadMem(tmp, 4, &value))
+	    FAULT();
+	if (registers[LoadReg] == I->rt)
+	    loadValue = registers[LoadValueReg];
+	else
+	    loadValue = RT;
+	switch (tmp & 0x3) {
+	  case 0:
+	    loadValue = value;
+	    break;
+	  case 1:
+	    loadValue = (loadValue & 0xff) | (value << 8);
+	    break;
+	  case 2:
+	    loadValue = (loadValue & 0xffff) | (value << 16);
+	    break;
+	  case 3:
+	    loadValue = (loadValue & 0xffffff) | (value << 24);
+	    break;
+	}
+	RETIRE(I->rt, loadValue, registers[NextPCReg] + 4);
+
+      op_lwr:
+	tmp = RS + I->extra;
+	ASSERT((tmp & 0x3) == 0);
+	if (!ReadMem(tmp, 4, &value))
+	    FAULT();
+	if (registers[LoadReg] == I->rt)
+	    loadValue = registers[LoadValueReg];
+	else
+	    loadValue = RT;
+	switch (tmp & 0x3) {
+	  case 0:
+	    loadValue = (loadValue & 0xffffff00) | ((value >> 24) & 0xff);
+	    break;
+	  case 1:
+	    loadValue = (loadValue & 0xffff0000) | ((value >> 16) & 0xffff);
+	    break;
+	  case 2:
+	    loadValue = (loadValue & 0xff000000) | ((value >> 8) & 0xffffff);
+	    break;
+	  case 3:
+	    loadValue = value;
+	    break;
+	}
+	RETIRE(I->rt, loadValue, registers[NextPCReg] + 4);
+
+      op_mfhi:
+	RD = registers[HiReg];
+	NEXT();
+
+      op_mflo:
+	RD = registers[LoReg];
+	NEXT();
+
+      op_mthi:
+	registers[HiReg] = RS;
+	NEXT();
+
+      op_mtlo:
+	registers[LoReg] = RS;
+	NEXT();
+
+      op_mult:
+	Mult(RS, RT, TRUE,
+	     &registers[HiReg], &registers[LoReg]);
+	NEXT();
+
+      op_multu:
+	Mult(RS, RT, FALSE,
+	     &registers[HiReg], &registers[LoReg]);
+	NEXT();
+
+      op_nor:
+	RD = ~(RS | RT);
+	NEXT();
+
+      op_or:
+	RD = RS | RT;
+	NEXT();
+
+      op_ori:
+	RT = RS | (I->extra & 0xffff);
+	NEXT();
+
+      op_sb:
+	if (!WriteMem((unsigned) (RS + I->extra), 1,
+		RT))
+	    FAULT();
+	NEXT();
+
+      op_sh:
+	if (!WriteMem((unsigned) (RS + I->extra), 2,
+		RT))
+	    FAULT();
+	NEXT();
+
+      op_sll:
+	RD = RT << I->extra;
+	NEXT();
+
+      op_sllv:
+	RD = RT << (RS & 0x1f);
+	NEXT();
+
+      op_slt:
+	RD = (RS < RT) ? 1 : 0;
+	NEXT();
+
+      op_slti:
+	RT = (RS < I->extra) ? 1 : 0;
+	NEXT();
+
+      op_sltiu:
+	rs = RS;
+	imm = I->extra;
+	RT = (rs < imm) ? 1 : 0;
+	NEXT();
+
+      op_sltu:
+	rs = RS;
+	rt = RT;
+	RD = (rs < rt) ? 1 : 0;
+	NEXT();
+
+      op_sra:
+	RD = RT >> I->extra;
+	NEXT();
+
+      op_srav:
+	RD = RT >> (RS & 0x1f);
+	NEXT();
+
+      op_srl:
+	rt = (unsigned int) RT;
+	RD = (int) (rt >> I->extra);
+	NEXT();
+
+      op_srlv:
+	rt = (unsigned int) RT;
+	RD = (int) (rt >> (RS & 0x1f));
+	NEXT();
+
+      op_sub:
+	diff = RS - RT;
+	if (((RS ^ RT) & SIGN_BIT) &&
+	    ((RS ^ diff) & SIGN_BIT)) {
+	    RaiseException(OverflowException, 0);
+	    FAULT();
+	}
+	RD = diff;
+	NEXT();
+
+      op_subu:
+	RD = RS - RT;
+	NEXT();
+
+      op_sw:
+	if (!WriteMem((unsigned) (RS + I->extra), 4,
+		RT))
+	    FAULT();
+	NEXT();
+
+      op_swl:
+	tmp = RS + I->extra;
+	ASSERT((tmp & 0x3) == 0);
+	if (!ReadMem((tmp & ~0x3), 4, &value))
+	    FAULT();
+	switch (tmp & 0x3) {
+	  case 0:
+	    value = RT;
+	    break;
+	  case 1:
+	    value = (value & 0xff000000) | ((RT >> 8) &
+					    0xffffff);
+	    break;
+	  case 2:
+	    value = (value & 0xffff0000) | ((RT >> 16) &
+					    0xffff);
+	    break;
+	  case 3:
+	    value = (value & 0xffffff00) | ((RT >> 24) &
+					    0xff);
+	    break;
+	}
+	if (!WriteMem((tmp & ~0x3), 4, value))
+	    FAULT();
+	NEXT();
+
+      op_swr:
+	tmp = RS + I->extra;
+	ASSERT((tmp & 0x3) == 0);
+	if (!ReadMem((tmp & ~0x3), 4, &value))
+	    FAULT();
+	switch (tmp & 0x3) {
+	  case 0:
+	    value = (value & 0xffffff) | (RT << 24);
+	    break;
+	  case 1:
+	    value = (value & 0xffff) | (RT << 16);
+	    break;
+	  case 2:
+	    value = (value & 0xff) | (RT << 8);
+	    break;
+	  case 3:
+	    value = RT;
+	    break;
+	}
+	if (!WriteMem((tmp & ~0x3), 4, value))
+	    FAULT();
+	NEXT();
+
+      op_syscall:
+	RaiseException(SyscallException, 0);
+	FAULT();
+
+      op_xor:
+	RD = RS ^ RT;
+	NEXT();
+
+      op_xori:
+	RT = RS ^ (I->extra & 0xffff);
+	NEXT();
+
+      op_illegal:
+	RaiseException(IllegalInstrException, 0);
+	FAULT();
+
+      op_bad:
+	ASSERT(FALSE);
+
+      fault:				// the faulting op was fetched too
+	CountBlockFetches(blockVpn, blockAsid, op - block->ops + 1);
+	interrupt->OneTick();
+	continue;
+      blockDone:
+	CountBlockFetches(blockVpn, blockAsid, op - block->ops);
+    }
+}
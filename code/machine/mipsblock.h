@@ -0,0 +1,60 @@
+// mipsblock.h
+//	Data structures for the basic-block threaded interpreter, an
+//	alternative to the one-instruction-at-a-time loop in mipssim.cc.
+//
+//	User code is split into basic blocks, each ending with a branch
+//	or jump (plus its delay slot), a syscall, or the end of a physical
+//	page.  A block is compiled once into an array of ops, each holding
+//	the address of the code that executes it and its pre-decoded
+//	operands, so running a block is just a chain of indirect jumps.
+//
+//	Blocks are cached by the physical address of their first
+//	instruction, and are thrown away by the same events that
+//	invalidate the decoded-instruction cache (writes into the page,
+//	or a change of page table).
+//
+//  DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MIPSBLOCK_H
+#define MIPSBLOCK_H
+
+#include "copyright.h"
+#include "machine.h"
+
+#define MaxBlockOps	32	// longest basic block we will compile
+#define BlockCacheSize	256	// number of blocks cached (direct-mapped,
+				// by physical word address)
+
+// One compiled instruction: where to jump to execute it, and its operands.
+
+class BlockOp {
+  public:
+    void *handler;		// label of the code that executes this op
+    Instruction instr;		// the decoded instruction
+};
+
+// A compiled basic block.  It is only valid while "generation" and
+// "frameGeneration" still match the machine's counters.
+
+class Block {
+  public:
+    int physAddr;		// physical address of the first instruction,
+				// -1 if this cache slot is unused
+    unsigned int generation;	// Machine::decodeGeneration when compiled
+    unsigned int frameGeneration; // generation of the frame holding the
+				// block, when compiled
+    int numOps;			// number of valid entries in "ops"
+    BlockOp ops[MaxBlockOps];
+
+    int runCount;		// times run since compiled (JitEngine only)
+    void *native;		// host code for the first "numNative" ops,
+    int numNative;		// or NULL if not translated (see mipsjit.h)
+    unsigned int nativeGeneration; // JitCompiler::generation when
+				// translated
+};
+
+#endif // MIPSBLOCK_H
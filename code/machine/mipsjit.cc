@@ -0,0 +1,827 @@
+// mipsjit.cc -- translation of MIPS basic blocks into host code
+//
+//   With "-jit", RunBlocks counts how often each basic block runs,
+//   and once a block has run JitThreshold times it is handed to
+//   JitCompiler::Compile, which generates x86 code for it.  The code
+//   keeps no MIPS state in host registers: %ebx points at
+//   Machine::registers, and every op reads and writes the registers
+//   there, so the machine state is exact whenever translated code
+//   returns.
+//
+//   Translated code does the same things OneInstruction does for each
+//   op, in the same order: the op itself, then the pending delayed
+//   load, then the PCs.  Since translation happens a block at a time,
+//   most of that is worked out here rather than at run time -- which
+//   register a load is pending for, what the PCs of the block are
+//   relative to the PC it was entered at, and so on.
+//
+//   Loads and stores call JitLoad and JitStore, which use
+//   Machine::Translate like ReadMem and WriteMem do.  If the access
+//   would raise an exception, or the op is one we don't translate,
+//   the code returns with the op not yet done, for OneInstruction to
+//   redo (and raise the exception, if need be).
+//
+//   The host code is 32-bit x86, using only instructions that are
+//   encoded the same way in 64-bit mode; only the prologue, the
+//   epilogue and calls to C++ differ between the two.
+//
+//   DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#include "machine.h"
+#include "mipssim.h"
+#include "mipsjit.h"
+#include "system.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#define JIT_HOST
+#endif
+
+// Host registers.  %ebx is saved by our caller, and holds
+// Machine::registers while translated code runs; the others are
+// scratch, and are clobbered by calls to C++.
+
+#define EAX	0
+#define ECX	1
+#define EDX	2
+#define EBX	3
+
+// Host condition codes, for Jcc, SETcc and CMOVcc.
+
+#define CondO	0x0		// overflow
+#define CondB	0x2		// unsigned less than
+#define CondE	0x4		// equal (zero)
+#define CondNE	0x5		// not equal (not zero)
+#define CondS	0x8		// negative
+#define CondNS	0x9		// not negative
+#define CondL	0xc		// signed less than
+#define CondLE	0xe		// signed less than or equal
+#define CondG	0xf		// signed greater than
+
+// ALU operations, as encoded in the "reg" field of opcode 0x81.
+
+#define AluAdd	0
+#define AluOr	1
+#define AluAnd	4
+#define AluSub	5
+#define AluXor	6
+#define AluCmp	7
+
+// Offset of a MIPS register from Machine::registers.
+
+#define R(r)	((r) * (int) sizeof(int))
+
+// Store a 32-bit value into generated code, least significant byte first.
+
+static void
+PutWord(char *at, int w)
+{
+    at[0] = (char) w;
+    at[1] = (char) (w >> 8);
+    at[2] = (char) (w >> 16);
+    at[3] = (char) (w >> 24);
+}
+
+//----------------------------------------------------------------------
+// JitCompiler::JitLoad, JitCompiler::JitStore
+// 	Called from translated code to read or write user memory, like
+//	ReadMem and WriteMem, except that they never raise an exception.
+//
+//	JitLoad returns TRUE, with the value (sign extended or not, as
+//	"opCode" says) in machine->jitValue, or FALSE if the load must
+//	be left to OneInstruction.
+//
+//	JitStore returns 0 if the store must be left to OneInstruction,
+//	1 if it was done, and 2 if it was done but wrote into a frame
+//	holding decoded code (which the caller may be running, so it
+//	should stop right away).
+//----------------------------------------------------------------------
+
+int
+JitCompiler::JitLoad(int addr, int opCode)
+{
+    int physAddr, value;
+    int size = (opCode == OP_LW) ? 4 :
+		(opCode == OP_LH || opCode == OP_LHU) ? 2 : 1;
+
+    if (machine->Translate(addr, &physAddr, size, FALSE) != NoException)
+	return FALSE;
+    switch (opCode) {
+      case OP_LB:
+	value = (signed char) machine->mainMemory[physAddr];
+	break;
+      case OP_LBU:
+	value = machine->mainMemory[physAddr] & 0xff;
+	break;
+      case OP_LH:
+	value = (short) ShortToHost(*(unsigned short *)
+				&machine->mainMemory[physAddr]);
+	break;
+      case OP_LHU:
+	value = ShortToHost(*(unsigned short *)
+				&machine->mainMemory[physAddr]) & 0xffff;
+	break;
+      default:
+	value = WordToHost(*(unsigned int *) &machine->mainMemory[physAddr]);
+	break;
+    }
+    machine->jitValue = value;
+    return TRUE;
+}
+
+int
+JitCompiler::JitStore(int addr, int opCode, int value)
+{
+    int physAddr, result = 1;
+    int size = (opCode == OP_SW) ? 4 : (opCode == OP_SH) ? 2 : 1;
+
+    if (machine->Translate(addr, &physAddr, size, TRUE) != NoException)
+	return 0;
+    if (machine->frameDecoded[physAddr / PageSize]) {
+	machine->InvalidateDecodeCache(physAddr / PageSize);
+	result = 2;
+    }
+    switch (size) {
+      case 1:
+	machine->mainMemory[physAddr] = (unsigned char) (value & 0xff);
+	break;
+      case 2:
+	*(unsigned short *) &machine->mainMemory[physAddr]
+		= ShortToMachine((unsigned short) (value & 0xffff));
+	break;
+      case 4:
+	*(unsigned int *) &machine->mainMemory[physAddr]
+		= WordToMachine((unsigned int) value);
+	break;
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------
+// JitCompiler::JitCompiler
+// 	Allocate space for translated code.  If the host has no space
+//	for us (or isn't an x86), Compile will always fail.
+//
+//	"m" -- the machine whose registers the code will work on
+//----------------------------------------------------------------------
+
+JitCompiler::JitCompiler(Machine *m)
+{
+#ifdef JIT_HOST
+    buffer = AllocExecutable(JitBufferSize);
+#else
+    buffer = NULL;
+#endif
+    used = 0;
+    generation = 0;
+    valueOffset = (char *) &m->jitValue - (char *) m->registers;
+}
+
+//----------------------------------------------------------------------
+// JitCompiler::~JitCompiler
+// 	Give back the space for translated code.
+//----------------------------------------------------------------------
+
+JitCompiler::~JitCompiler()
+{
+    if (buffer != NULL)
+	DeallocExecutable(buffer, JitBufferSize);
+}
+
+//----------------------------------------------------------------------
+// Translatable
+// 	Return TRUE if we know how to generate code for an op.  The
+//	unaligned loads and stores, and anything that always traps,
+//	are left to OneInstruction.
+//----------------------------------------------------------------------
+
+static bool
+Translatable(int opCode)
+{
+    switch (opCode) {
+      case OP_LWL: case OP_LWR: case OP_SWL: case OP_SWR:
+      case OP_SYSCALL: case OP_RES: case OP_UNIMP: case OP_RFE:
+	return FALSE;
+      default:
+	return TRUE;
+    }
+}
+
+static bool
+IsBranch(int opCode)
+{
+    switch (opCode) {
+      case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+      case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+      case OP_J: case OP_JAL: case OP_JALR: case OP_JR:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// JitCompiler::Compile
+// 	Generate host code for as much of "block" as we can: it stops
+//	before the first op we can't translate, and before a branch
+//	whose delay slot we can't translate.
+//
+//	Returns FALSE, leaving block->native NULL, if we can't translate
+//	even the first op.  When the buffer is full, all the code in it
+//	is thrown away (by bumping "generation") to make room.
+//----------------------------------------------------------------------
+
+bool
+JitCompiler::Compile(Block *block)
+{
+    Instruction *instr, *next;
+    char *start;
+    int n;
+
+    block->native = NULL;
+    block->runCount = 0;		// if we fail, try again later
+    if (buffer == NULL)
+	return FALSE;
+    if (used + JitMaxBlockCode > JitBufferSize) {
+	used = 0;
+	generation++;
+    }
+    start = code = buffer + used;
+    loadState = LoadUnknown;
+    branchAt = -1;
+    numExits = 0;
+
+    Prologue();
+    for (n = 0; n < block->numOps; n++) {
+	instr = &block->ops[n].instr;
+	if (!Translatable(instr->opCode))
+	    break;
+	if (IsBranch(instr->opCode)) {
+	    if (n + 1 == block->numOps)
+		break;
+	    next = &block->ops[n + 1].instr;
+	    if (!Translatable(next->opCode) || IsBranch(next->opCode))
+		break;
+	    branchAt = n;
+	}
+	CompileOp(instr, n);
+    }
+    if (n == 0)
+	return FALSE;
+    Exit(n);
+    GenerateExits();
+
+    ASSERT(code - start <= JitMaxBlockCode);
+    used = (code - buffer + 15) & ~15;
+    block->native = (void *) start;
+    block->numNative = n;
+    block->nativeGeneration = generation;
+    stats->numJitBlocks++;
+    DEBUG('j', "Translated %d ops at physical address 0x%x, %d bytes\n",
+	  n, block->physAddr, code - start);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// JitCompiler::CompileOp
+// 	Generate code for op number "index" of a block, which does the
+//	same as the corresponding case in Machine::OneInstruction.
+//
+//	"pc", below, is the address of the op relative to the PC the
+//	block was entered at, which is in registers[PCReg] until we
+//	get to the branch, if any.
+//----------------------------------------------------------------------
+
+void
+JitCompiler::CompileOp(Instruction *instr, int index)
+{
+    int rs = instr->rs, rt = instr->rt, rd = instr->rd;
+    int extra = instr->extra;
+    int pc = index * 4;
+    int cond;
+    char *skip, *done;
+
+    switch (instr->opCode) {
+      case OP_ADD:
+	Load(EAX, rs);
+	ArithReg(AluAdd, EAX, rt);
+	ExitIf(CondO, index);
+	Store(EAX, rd);
+	break;
+
+      case OP_ADDI:
+	Load(EAX, rs);
+	Arith(AluAdd, EAX, extra);
+	ExitIf(CondO, index);
+	Store(EAX, rt);
+	break;
+
+      case OP_ADDIU:
+	Load(EAX, rs);
+	Arith(AluAdd, EAX, extra);
+	Store(EAX, rt);
+	break;
+
+      case OP_ADDU:
+	Load(EAX, rs);
+	ArithReg(AluAdd, EAX, rt);
+	Store(EAX, rd);
+	break;
+
+      case OP_AND:
+	Load(EAX, rs);
+	ArithReg(AluAnd, EAX, rt);
+	Store(EAX, rd);
+	break;
+
+      case OP_ANDI:
+	Load(EAX, rs);
+	Arith(AluAnd, EAX, extra & 0xffff);
+	Store(EAX, rt);
+	break;
+
+      case OP_BEQ:
+      case OP_BNE:
+	Load(EAX, rs);
+	ArithReg(AluCmp, EAX, rt);
+	cond = (instr->opCode == OP_BEQ) ? CondE : CondNE;
+	goto branch;
+
+      case OP_BGEZ:
+      case OP_BGEZAL:
+      case OP_BGTZ:
+      case OP_BLEZ:
+      case OP_BLTZ:
+      case OP_BLTZAL:
+	if (instr->opCode == OP_BGEZAL || instr->opCode == OP_BLTZAL) {
+	    Byte(0x8b); Mem(ECX, R(PCReg));	// r31 = NextPC + 4
+	    LeaPC(ECX, ECX, pc + 8);
+	    Store(ECX, R31);
+	}
+	Load(EAX, rs);
+	Byte(0x85); Byte(0xc0);			// test %eax,%eax
+	switch (instr->opCode) {
+	  case OP_BGEZ: case OP_BGEZAL:	cond = CondNS; break;
+	  case OP_BGTZ:			cond = CondG; break;
+	  case OP_BLEZ:			cond = CondLE; break;
+	  default:			cond = CondS; break;
+	}
+      branch:
+	// %edx = taken ? NextPC + offset : NextPC + 4
+	Byte(0x8b); Mem(ECX, R(PCReg));
+	LeaPC(EDX, ECX, pc + 8);
+	LeaPC(ECX, ECX, pc + 4 + IndexToAddr(extra));
+	Byte(0x0f); Byte(0x40 | cond); Byte(0xd1);	// cmovcc %ecx,%edx
+	goto jump;
+
+      case OP_J:
+      case OP_JAL:
+	if (instr->opCode == OP_JAL) {
+	    Byte(0x8b); Mem(ECX, R(PCReg));
+	    LeaPC(ECX, ECX, pc + 8);
+	    Store(ECX, R31);
+	}
+	Byte(0x8b); Mem(ECX, R(PCReg));
+	LeaPC(EDX, ECX, pc + 8);
+	Arith(AluAnd, EDX, 0xf0000000);
+	Arith(AluOr, EDX, IndexToAddr(extra));
+	goto jump;
+
+      case OP_JALR:
+      case OP_JR:
+	if (instr->opCode == OP_JALR) {
+	    Byte(0x8b); Mem(ECX, R(PCReg));
+	    LeaPC(ECX, ECX, pc + 8);
+	    Store(ECX, rd);
+	}
+	Load(EDX, rs);
+      jump:
+	// the branch is done: PC moves to the delay slot, and NextPC
+	// to the target in %edx
+	Byte(0x8b); Mem(EAX, R(PCReg));
+	LeaPC(ECX, EAX, pc);
+	Store(ECX, PrevPCReg);
+	LeaPC(ECX, EAX, pc + 4);
+	Store(ECX, PCReg);
+	Store(EDX, NextPCReg);
+	break;
+
+      case OP_DIV:
+      case OP_DIVU:
+	Load(ECX, rt);
+	Byte(0x85); Byte(0xc9);			// test %ecx,%ecx
+	Byte(0x74); skip = code; Byte(0);	// jz
+	Load(EAX, rs);
+	if (instr->opCode == OP_DIV) {
+	    Byte(0x99);				// cltd
+	    Byte(0xf7); Byte(0xf9);		// idiv %ecx
+	} else {
+	    Byte(0x31); Byte(0xd2);		// xor %edx,%edx
+	    Byte(0xf7); Byte(0xf1);		// div %ecx
+	}
+	Store(EAX, LoReg);
+	Store(EDX, HiReg);
+	Byte(0xeb); done = code; Byte(0);	// jmp
+	*skip = (char) (code - skip - 1);
+	StoreImm(LoReg, 0);
+	StoreImm(HiReg, 0);
+	*done = (char) (code - done - 1);
+	break;
+
+      case OP_LB:
+      case OP_LBU:
+      case OP_LH:
+      case OP_LHU:
+      case OP_LW:
+	Load(EAX, rs);
+	Arith(AluAdd, EAX, extra);
+	Call((void *) JitLoad, instr->opCode);
+	Byte(0x85); Byte(0xc0);			// test %eax,%eax
+	ExitIf(CondE, index);
+	Byte(0x8b); Mem(EDX, valueOffset);
+	Retire(TRUE, rt);
+	return;
+
+      case OP_LUI:
+	StoreImm(rt, extra << 16);
+	break;
+
+      case OP_MFHI:
+	Load(EAX, HiReg);
+	Store(EAX, rd);
+	break;
+
+      case OP_MFLO:
+	Load(EAX, LoReg);
+	Store(EAX, rd);
+	break;
+
+      case OP_MTHI:
+	Load(EAX, rs);
+	Store(EAX, HiReg);
+	break;
+
+      case OP_MTLO:
+	Load(EAX, rs);
+	Store(EAX, LoReg);
+	break;
+
+      case OP_MULT:
+      case OP_MULTU:
+	Load(EAX, rs);
+	Load(ECX, rt);
+	Byte(0xf7);
+	Byte((instr->opCode == OP_MULT) ? 0xe9 : 0xe1);	// imul/mul %ecx
+	Store(EAX, LoReg);
+	Store(EDX, HiReg);
+	break;
+
+      case OP_NOR:
+	Load(EAX, rs);
+	ArithReg(AluOr, EAX, rt);
+	Byte(0xf7); Byte(0xd0);			// not %eax
+	Store(EAX, rd);
+	break;
+
+      case OP_OR:
+	Load(EAX, rs);
+	ArithReg(AluOr, EAX, rt);
+	Store(EAX, rd);
+	break;
+
+      case OP_ORI:
+	Load(EAX, rs);
+	Arith(AluOr, EAX, extra & 0xffff);
+	Store(EAX, rt);
+	break;
+
+      case OP_SB:
+      case OP_SH:
+      case OP_SW:
+	Load(EAX, rs);
+	Arith(AluAdd, EAX, extra);
+	Load(ECX, rt);
+	Call((void *) JitStore, instr->opCode);
+	Byte(0x85); Byte(0xc0);			// test %eax,%eax
+	ExitIf(CondE, index);
+	Byte(0x89); Byte(0xc2);			// mov %eax,%edx
+	Retire(FALSE, 0);
+	Byte(0x83); Byte(0xfa); Byte(1);	// cmp $1,%edx
+	ExitIf(CondNE, index + 1);		// wrote into code
+	return;
+
+      case OP_SLL:
+      case OP_SRA:
+      case OP_SRL:
+	Load(EAX, rt);
+	Byte(0xc1);
+	Byte((instr->opCode == OP_SLL) ? 0xe0 :	// shl/sar/shr $n,%eax
+	     (instr->opCode == OP_SRA) ? 0xf8 : 0xe8);
+	Byte(extra);
+	Store(EAX, rd);
+	break;
+
+      case OP_SLLV:
+      case OP_SRAV:
+      case OP_SRLV:
+	Load(ECX, rs);
+	Load(EAX, rt);
+	Byte(0xd3);
+	Byte((instr->opCode == OP_SLLV) ? 0xe0 :	// shl/sar/shr %cl,%eax
+	     (instr->opCode == OP_SRAV) ? 0xf8 : 0xe8);
+	Store(EAX, rd);
+	break;
+
+      case OP_SLT:
+      case OP_SLTU:
+	Load(EAX, rs);
+	ArithReg(AluCmp, EAX, rt);
+	cond = (instr->opCode == OP_SLT) ? CondL : CondB;
+	Byte(0x0f); Byte(0x90 | cond); Byte(0xc0);	// setcc %al
+	Byte(0x0f); Byte(0xb6); Byte(0xc0);	// movzbl %al,%eax
+	Store(EAX, rd);
+	break;
+
+      case OP_SLTI:
+      case OP_SLTIU:
+	Load(EAX, rs);
+	Arith(AluCmp, EAX, extra);
+	cond = (instr->opCode == OP_SLTI) ? CondL : CondB;
+	Byte(0x0f); Byte(0x90 | cond); Byte(0xc0);	// setcc %al
+	Byte(0x0f); Byte(0xb6); Byte(0xc0);	// movzbl %al,%eax
+	Store(EAX, rt);
+	break;
+
+      case OP_SUB:
+	Load(EAX, rs);
+	ArithReg(AluSub, EAX, rt);
+	ExitIf(CondO, index);
+	Store(EAX, rd);
+	break;
+
+      case OP_SUBU:
+	Load(EAX, rs);
+	ArithReg(AluSub, EAX, rt);
+	Store(EAX, rd);
+	break;
+
+      case OP_XOR:
+	Load(EAX, rs);
+	ArithReg(AluXor, EAX, rt);
+	Store(EAX, rd);
+	break;
+
+      case OP_XORI:
+	Load(EAX, rs);
+	Arith(AluXor, EAX, extra & 0xffff);
+	Store(EAX, rt);
+	break;
+
+      default:
+	ASSERT(FALSE);
+    }
+    Retire(FALSE, 0);
+}
+
+//----------------------------------------------------------------------
+// JitCompiler::Retire
+// 	Generate the code that finishes an op, as DelayedLoad does: do
+//	the load pending from the op before, if any, and make the op's
+//	own load (in %edx) pending.  Uses %eax and %ecx.
+//
+//	"isLoad" -- is the op a load?
+//	"rt" -- if so, the register being loaded
+//----------------------------------------------------------------------
+
+void
+JitCompiler::Retire(bool isLoad, int rt)
+{
+    if (loadState == LoadUnknown) {
+	Byte(0x8b); Mem(EAX, R(LoadReg));
+	Byte(0x8b); Mem(ECX, R(LoadValueReg));
+	Byte(0x89); Byte(0x0c); Byte(0x83);	// mov %ecx,(%ebx,%eax,4)
+	Byte(0xc7); Mem(EAX, R(0)); Word(0);	// registers[0] = 0
+    } else if (loadState != LoadNone && loadState != 0) {
+	Byte(0x8b); Mem(ECX, R(LoadValueReg));
+	Store(ECX, loadState);
+    }
+
+    if (isLoad) {
+	StoreImm(LoadReg, rt);
+	Store(EDX, LoadValueReg);
+	loadState = rt;
+    } else if (loadState != LoadNone) {
+	StoreImm(LoadReg, 0);
+	StoreImm(LoadValueReg, 0);
+	loadState = LoadNone;
+    }
+}
+
+//----------------------------------------------------------------------
+// JitCompiler::Exit
+// 	Generate code to return to RunBlocks, having done the first
+//	"count" ops of the block; the PCs are set to point at the next.
+//----------------------------------------------------------------------
+
+void
+JitCompiler::Exit(int count)
+{
+    if (branchAt < 0 || count <= branchAt) {
+	if (count > 0) {			// PCs are relative to the
+	    Byte(0x8b); Mem(EAX, R(PCReg));	// one the block started at
+	    LeaPC(ECX, EAX, count * 4 - 4);
+	    Store(ECX, PrevPCReg);
+	    LeaPC(ECX, EAX, count * 4 + 4);
+	    Store(ECX, NextPCReg);
+	    LeaPC(ECX, EAX, count * 4);
+	    Store(ECX, PCReg);
+	}
+    } else if (count == branchAt + 2) {		// past the delay slot
+	Load(EAX, PCReg);
+	Store(EAX, PrevPCReg);
+	Load(EAX, NextPCReg);
+	Store(EAX, PCReg);
+	Arith(AluAdd, EAX, 4);
+	Store(EAX, NextPCReg);
+    }						// else in the delay slot: the
+						// branch already set the PCs
+    Byte(0xb8); Word(count);			// mov $count,%eax
+    Epilogue();
+}
+
+//----------------------------------------------------------------------
+// JitCompiler::ExitIf
+// 	Generate a jump to code that returns "count" if host condition
+//	"cond" holds.  The code it jumps to is generated at the end of
+//	the block, by GenerateExits, out of the way of the common path.
+//----------------------------------------------------------------------
+
+void
+JitCompiler::ExitIf(int cond, int count)
+{
+    ASSERT(numExits < JitMaxExits);
+    Byte(0x0f); Byte(0x80 | cond);		// jcc rel32
+    exitJump[numExits] = code;
+    exitCount[numExits] = count;
+    numExits++;
+    Word(0);
+}
+
+//----------------------------------------------------------------------
+// JitCompiler::GenerateExits
+// 	Generate the code for each early return, and point the jumps
+//	to it.  Exits that return the same count share their code.
+//----------------------------------------------------------------------
+
+void
+JitCompiler::GenerateExits()
+{
+    char *target[MaxBlockOps + 2];
+    char *jump;
+    int i;
+
+    for (i = 0; i < MaxBlockOps + 2; i++)
+	target[i] = NULL;
+    for (i = 0; i < numExits; i++) {
+	if (target[exitCount[i]] == NULL) {
+	    target[exitCount[i]] = code;
+	    Exit(exitCount[i]);
+	}
+	jump = exitJump[i];
+	PutWord(jump, target[exitCount[i]] - (jump + 4));
+    }
+}
+
+//----------------------------------------------------------------------
+// The emitter.  Each routine generates one host instruction; "reg" is
+// a host register, "mipsReg" a MIPS register (or one of the special
+// registers, like PCReg), found at the matching offset from %ebx.
+//----------------------------------------------------------------------
+
+void
+JitCompiler::Word(int w)
+{
+    PutWord(code, w);
+    code += 4;
+}
+
+// The ModRM byte (and displacement) for the operand "offset(%ebx)".
+void
+JitCompiler::Mem(int reg, int offset)
+{
+    if (offset >= -128 && offset < 128) {
+	Byte(0x40 | (reg << 3) | EBX);
+	Byte(offset);
+    } else {
+	Byte(0x80 | (reg << 3) | EBX);
+	Word(offset);
+    }
+}
+
+// reg = registers[mipsReg]
+void
+JitCompiler::Load(int reg, int mipsReg)
+{
+    if (mipsReg == 0) {
+	Byte(0x31); Byte(0xc0 | (reg << 3) | reg);	// xor reg,reg
+    } else {
+	Byte(0x8b); Mem(reg, R(mipsReg));
+    }
+}
+
+// registers[mipsReg] = reg; register 0 is always left as 0
+void
+JitCompiler::Store(int reg, int mipsReg)
+{
+    if (mipsReg != 0) {
+	Byte(0x89); Mem(reg, R(mipsReg));
+    }
+}
+
+// registers[mipsReg] = value
+void
+JitCompiler::StoreImm(int mipsReg, int value)
+{
+    if (mipsReg != 0) {
+	Byte(0xc7); Mem(EAX, R(mipsReg)); Word(value);
+    }
+}
+
+// reg = reg op value
+void
+JitCompiler::Arith(int op, int reg, int value)
+{
+    Byte(0x81); Byte(0xc0 | (op << 3) | reg); Word(value);
+}
+
+// reg = reg op registers[mipsReg]
+void
+JitCompiler::ArithReg(int op, int reg, int mipsReg)
+{
+    if (mipsReg == 0)
+	Arith(op, reg, 0);
+    else {
+	Byte(0x03 | (op << 3)); Mem(reg, R(mipsReg));
+    }
+}
+
+// reg = base + offset, without changing the condition codes
+void
+JitCompiler::LeaPC(int reg, int base, int offset)
+{
+    Byte(0x8d); Byte(0x80 | (reg << 3) | base); Word(offset);
+}
+
+// %eax = func(%eax, arg, %ecx), following the host's C calling
+// convention; our prologue left the stack aligned as it requires.
+void
+JitCompiler::Call(void *func, int arg)
+{
+#ifdef __x86_64__
+    unsigned long addr = (unsigned long) func;
+    int i;
+
+    Byte(0x89); Byte(0xc7);			// mov %eax,%edi
+    Byte(0xbe); Word(arg);			// mov $arg,%esi
+    Byte(0x89); Byte(0xca);			// mov %ecx,%edx
+    Byte(0x48); Byte(0xb8);			// movabs $func,%rax
+    for (i = 0; i < 8; i++)
+	Byte((int) (addr >> (i * 8)));
+#else
+    Byte(0x89); Byte(0x04); Byte(0x24);		// mov %eax,(%esp)
+    Byte(0xc7); Byte(0x44); Byte(0x24); Byte(4);	// movl $arg,4(%esp)
+    Word(arg);
+    Byte(0x89); Byte(0x4c); Byte(0x24); Byte(8);	// mov %ecx,8(%esp)
+    Byte(0xb8); Word((int) func);		// mov $func,%eax
+#endif
+    Byte(0xff); Byte(0xd0);			// call *%eax
+}
+
+// Save %ebx, point it at the registers, and make room for the
+// arguments of calls to C++.
+void
+JitCompiler::Prologue()
+{
+    Byte(0x53);					// push %ebx
+#ifdef __x86_64__
+    Byte(0x48); Byte(0x89); Byte(0xfb);		// mov %rdi,%rbx
+#else
+    Byte(0x8b); Byte(0x5c); Byte(0x24); Byte(8);	// mov 8(%esp),%ebx
+    Byte(0x83); Byte(0xec); Byte(24);		// sub $24,%esp
+#endif
+}
+
+void
+JitCompiler::Epilogue()
+{
+#ifndef __x86_64__
+    Byte(0x83); Byte(0xc4); Byte(24);		// add $24,%esp
+#endif
+    Byte(0x5b);					// pop %ebx
+    Byte(0xc3);					// ret
+}
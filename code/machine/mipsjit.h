@@ -0,0 +1,100 @@
+// mipsjit.h
+//	Data structures for the JIT, which translates frequently run
+//	basic blocks (see mipsblock.h) into host machine code.
+//
+//	The translated code works directly on Machine::registers, and
+//	behaves exactly like running the block's ops one at a time,
+//	except that it does not advance simulated time: it returns the
+//	number of instructions it completed, and the caller accounts for
+//	them all at once.  So the caller only runs translated code when no
+//	interrupt can become due before the block ends.
+//
+//	Anything the translated code can't do by itself -- an exception,
+//	a system call, an unusual instruction -- makes it return early,
+//	leaving the machine exactly as it was just before the instruction
+//	in question, for OneInstruction to execute.
+//
+//	Code is only generated for x86 hosts (32 or 64 bit); elsewhere
+//	Compile always fails, and -jit behaves just like -bb.
+//
+//  DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MIPSJIT_H
+#define MIPSJIT_H
+
+#include "copyright.h"
+#include "machine.h"
+#include "mipsblock.h"
+
+#define JitThreshold	16		// runs of a block before we
+					// translate it
+#define JitBufferSize	(256 * 1024)	// bytes of space for host code
+#define JitMaxBlockCode	(MaxBlockOps * 256)	// more than enough space
+					// for the code of one block
+#define JitMaxExits	(MaxBlockOps * 2 + 1)	// early returns per block
+
+// Translated code is called with Machine::registers, and returns the
+// number of user instructions it executed.
+
+typedef int (*JitCode)(int *registers);
+
+// How a pending delayed load stands at some point during translation.
+
+#define LoadUnknown	-1	// whatever the previous block left
+#define LoadNone	-2	// nothing pending
+				// otherwise, the register being loaded
+
+class JitCompiler {
+  public:
+    JitCompiler(Machine *m);		// allocate space for host code
+    ~JitCompiler();
+
+    bool Compile(Block *block);		// translate as much of "block"
+					// as we can; FALSE if nothing
+    unsigned int generation;		// bumped whenever all translated
+					// code is thrown away
+
+  private:
+    char *buffer;			// space for host code
+    int used;				// bytes of "buffer" in use
+    int valueOffset;			// where Machine::jitValue is,
+					// relative to Machine::registers
+
+    char *code;				// where the next byte goes
+    int loadState;			// delayed load pending, LoadNone, or
+					// LoadUnknown
+    int branchAt;			// the branch in the block, if any
+    int numExits;			// early returns to be generated
+    char *exitJump[JitMaxExits];	// the jump to each of them
+    int exitCount[JitMaxExits];		// and what it returns
+
+    void CompileOp(Instruction *instr, int index);
+    void Retire(bool isLoad, int rt);	// the delayed load, after an op
+    void Exit(int count);		// leave, having done "count" ops
+    void ExitIf(int cond, int count);	// leave, if "cond" holds
+    void GenerateExits();		// the code for ExitIf
+
+    // The emitter, which knows about the host instruction set.
+    void Byte(int b) { *code++ = (char) b; }
+    void Word(int w);
+    void Mem(int reg, int offset);
+    void Load(int reg, int mipsReg);
+    void Store(int reg, int mipsReg);
+    void StoreImm(int mipsReg, int value);
+    void Arith(int op, int reg, int value);
+    void ArithReg(int op, int reg, int mipsReg);
+    void LeaPC(int reg, int base, int offset);
+    void Call(void *func, int arg);
+    void Prologue();
+    void Epilogue();
+
+    // Called by translated code, to do loads and stores.
+    static int JitLoad(int addr, int opCode);
+    static int JitStore(int addr, int opCode, int value);
+};
+
+#endif // MIPSJIT_H
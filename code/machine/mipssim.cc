@@ -16,8 +16,6 @@
 #include "mipssim.h"
 #include "system.h"
 
-static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
-
 //----------------------------------------------------------------------
 // Machine::Run
 // 	Simulate the execution of a user-level program on Nachos.
@@ -25,25 +23,66 @@ static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 //
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
+//
+//	Instructions are run in batches: we ask the interrupt system how
+//	long until the next interrupt is due, and until then just count
+//	the ticks (AdvanceTicks), with the full OneTick only for the
+//	instruction that reaches the deadline.  A batch ends early if an
+//	instruction traps into the kernel, since the kernel may schedule
+//	a new interrupt or switch threads; either way, simulated time is
+//	exactly what it would be with OneTick after every instruction.
 //----------------------------------------------------------------------
 
 void
 Machine::Run()
 {
     Instruction *instr = new Instruction;  // storage for decoded instruction
+    int quiet;
 
     if(DebugIsEnabled('m'))
         printf("Starting thread \"%s\" at time %d\n",
 	       currentThread->getName(), stats->totalTicks);
     interrupt->setStatus(UserMode);
+    if (engine != InterpEngine && !singleStep && !DebugIsEnabled('m'))
+	RunBlocks();		// never returns; the debugger and the
+				// 'm' trace need the instruction-at-a-time
+				// loop below
     for (;;) {
-        OneInstruction(instr);
+	quiet = singleStep ? 0 : QuietSteps();
+	trapped = FALSE;
+	while (--quiet > 0) {		// no interrupt can be due yet
+	    OneInstruction(instr);
+	    if (trapped)
+		break;
+	    interrupt->AdvanceTicks(UserTick);
+	}
+	if (!trapped)
+	    OneInstruction(instr);
 	interrupt->OneTick();
 	if (singleStep && (runUntilTime <= stats->totalTicks))
 	  Debugger();
     }
 }
 
+//----------------------------------------------------------------------
+// Machine::QuietSteps
+// 	Return how many more user instructions can be run before one of
+//	them brings simulated time up to the next pending interrupt: the
+//	ones before that can be accounted for with AdvanceTicks, and that
+//	one needs a full OneTick.  Zero when "-d i" is tracing every tick.
+//----------------------------------------------------------------------
+
+int
+Machine::QuietSteps()
+{
+    int ticks;
+
+    if (DebugIsEnabled('i'))
+	return 0;
+    ticks = interrupt->TicksUntilNextInterrupt();
+    return ticks / UserTick + (ticks % UserTick != 0);
+}
+
 
 //----------------------------------------------------------------------
 // TypeToReg
@@ -93,16 +132,33 @@ TypeToReg(RegType reg, Instruction *instr)
 void
 Machine::OneInstruction(Instruction *instr)
 {
-    int raw;
+    int physAddr, word;
+    ExceptionType exception;
     int nextLoadReg = 0; 	
     int nextLoadValue = 0; 	// record delayed load operation, to apply
 				// in the future
 
-    // Fetch instruction 
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
+    // Fetch instruction.  We still translate every fetch (so that page
+    // faults and the use bits behave exactly as before), but the decoded
+    // form is cached by physical word, so a hit skips both the memory 
+    // read and Instruction::Decode.
+    exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+    if (exception != NoException) {
+	RaiseException(exception, registers[PCReg]);
 	return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
+    }
+    word = physAddr / sizeof(int);
+    if (decodeValid[word]) {
+	*instr = decodeCache[word];
+	stats->numDecodeHits++;
+    } else {
+	instr->value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+	instr->Decode();
+	decodeCache[word] = *instr;
+	decodeValid[word] = TRUE;
+	frameDecoded[physAddr / PageSize] = TRUE;
+	stats->numDecodeMisses++;
+    }
 
     if (DebugIsEnabled('m')) {
        struct OpString *str = &opStrings[instr->opCode];
@@ -373,7 +429,7 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_OR:
-	registers[instr->rd] = registers[instr->rs] | registers[instr->rs];
+	registers[instr->rd] = registers[instr->rs] | registers[instr->rt];
 	break;
 	
       case OP_ORI:
@@ -442,16 +498,14 @@ Machine::OneInstruction(Instruction *instr)
 	    (registers[instr->rs] & 0x1f);
 	break;
 	
-      case OP_SRL:
-	tmp = registers[instr->rt];
-	tmp >>= instr->extra;
-	registers[instr->rd] = tmp;
+      case OP_SRL:		// a logical shift: no sign extension
+	rt = (unsigned int) registers[instr->rt];
+	registers[instr->rd] = (int) (rt >> instr->extra);
 	break;
 	
       case OP_SRLV:
-	tmp = registers[instr->rt];
-	tmp >>= (registers[instr->rs] & 0x1f);
-	registers[instr->rd] = tmp;
+	rt = (unsigned int) registers[instr->rt];
+	registers[instr->rd] = (int) (rt >> (registers[instr->rs] & 0x1f));
 	break;
 	
       case OP_SUB:	  
@@ -581,6 +635,42 @@ Machine::DelayedLoad(int nextReg, int nextValue)
     registers[0] = 0; 	// and always make sure R0 stays zero.
 }
 
+//----------------------------------------------------------------------
+// Machine::FlushDecodeCache
+// 	Forget every pre-decoded instruction.  Called whenever the
+//	kernel changes the page table (for instance, on a context switch
+//	or after loading a new program into mainMemory behind our back).
+//----------------------------------------------------------------------
+
+void
+Machine::FlushDecodeCache()
+{
+    for (unsigned int i = 0; i < MemorySize / sizeof(int); i++)
+	decodeValid[i] = FALSE;
+    for (int frame = 0; frame < NumPhysPages; frame++)
+	frameDecoded[frame] = FALSE;
+    decodeGeneration++;		// and every compiled basic block
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateDecodeCache
+// 	Forget the pre-decoded instructions in one physical page frame,
+//	because something wrote to it.
+//
+//	"frame" -- the physical page number that was modified
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateDecodeCache(int frame)
+{
+    int first = frame * PageSize / sizeof(int);
+
+    for (unsigned int i = 0; i < PageSize / sizeof(int); i++)
+	decodeValid[first + i] = FALSE;
+    frameDecoded[frame] = FALSE;
+    frameGeneration[frame]++;	// and the basic blocks in this frame
+}
+
 //----------------------------------------------------------------------
 // Instruction::Decode
 // 	Decode a MIPS instruction 
@@ -632,7 +722,7 @@ Instruction::Decode()
 // 	double-length result of the multiplication.
 //----------------------------------------------------------------------
 
-static void
+void
 Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr)
 {
     if ((a == 0) || (b == 0)) {
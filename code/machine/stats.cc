@@ -22,6 +22,12 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numPageIns = numPageOuts = numPageCopies = 0;
+    numTLBHits = numTLBMisses = 0;
+    numDecodeHits = numDecodeMisses = 0;
+    numJitBlocks = 0;
+    numStackAllocs = numStackReuses = 0;
+    hostStartTime = HostTime();
 }
 
 //----------------------------------------------------------------------
@@ -33,12 +39,29 @@ Statistics::Statistics()
 void
 Statistics::Print()
 {
+    double hostSeconds;
+
     printf("Ticks: total %d, idle %d, system %d, user %d\n", totalTicks, 
 	idleTicks, systemTicks, userTicks);
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
-    printf("Paging: faults %d\n", numPageFaults);
+    printf("Paging: faults %d, page-ins %d, page-outs %d, copied on write %d\n",
+	numPageFaults, numPageIns, numPageOuts, numPageCopies);
+    if (numTLBHits + numTLBMisses > 0)
+	printf("TLB: hits %d, misses %d (%.2f%% hits)\n", numTLBHits,
+	    numTLBMisses, numTLBHits * 100.0 / (numTLBHits + numTLBMisses));
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
+    printf("Decode cache: hits %d, misses %d\n", numDecodeHits, 
+	numDecodeMisses);
+    printf("JIT: blocks translated %d\n", numJitBlocks);
+    if (numStackAllocs + numStackReuses > 0)
+	printf("Thread stacks: allocated %d, reused %d (%d%% pool hits)\n",
+	    numStackAllocs, numStackReuses, 
+	    numStackReuses * 100 / (numStackAllocs + numStackReuses));
+    hostSeconds = HostTime() - hostStartTime;
+    if (hostSeconds > 0)
+	printf("Host: %.3f seconds, %.0f user instructions/second\n",
+	    hostSeconds, userTicks / UserTick / hostSeconds);
 }
@@ -33,8 +33,20 @@ class Statistics {
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
+    int numPageIns;		// pages read in from swap
+    int numPageOuts;		// pages written out to swap
+    int numPageCopies;		// pages copied on write, after a Fork
+    int numTLBHits;		// references found in the TLB
+    int numTLBMisses;		// and not, so the kernel had to refill it
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numDecodeHits;		// user instructions found pre-decoded
+    int numDecodeMisses;	// user instructions fetched and decoded
+    int numJitBlocks;		// basic blocks translated into host code
+    int numStackAllocs;		// thread stacks newly allocated
+    int numStackReuses;		// thread stacks reused from the pool
+    double hostStartTime;	// host wall-clock time when Nachos started,
+				// to report how fast user code ran
 
     Statistics(); 		// initialize everything to zero
 
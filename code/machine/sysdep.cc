@@ -468,25 +468,38 @@ Random()
 //	the end of the array.  Particularly useful for catching overflow
 //	beyond fixed-size thread execution stacks.
 //
+//	The array is mapped separately from the heap, so that the
+//	boundary pages can be protected without hurting anything else;
+//	it is rounded up to a whole number of pages.  If the host won't
+//	protect them, the array still works, and BoundedArraysGuarded
+//	says so.
+//
 //	Note: Just return the useful part!
 //
 //	"size" -- amount of useful space needed (in bytes)
 //----------------------------------------------------------------------
 
+static bool guardsWork = TRUE;	// have all the boundary pages been
+				// protected?
+
 char * 
 AllocBoundedArray(int size)
 {
     int pgSize = getpagesize();
-    char *ptr = new char[pgSize * 2 + size];
-
-    //mprotect(ptr, pgSize, 0);
-    //mprotect(ptr + pgSize + size, pgSize, 0);
+    int bytes = divRoundUp(size, pgSize) * pgSize;
+    char *ptr = (char *) mmap(NULL, pgSize * 2 + bytes, 
+				PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+
+    ASSERT(ptr != (char *) MAP_FAILED);
+    if (mprotect(ptr, pgSize, PROT_NONE) != 0
+	    || mprotect(ptr + pgSize + bytes, pgSize, PROT_NONE) != 0)
+	guardsWork = FALSE;
     return ptr + pgSize;
 }
 
 //----------------------------------------------------------------------
 // DeallocBoundedArray
-// 	Deallocate an array of integers, unprotecting its two boundary pages.
+// 	Deallocate an array of integers, and its two boundary pages.
 //
 //	"ptr" -- the array to be deallocated
 //	"size" -- amount of useful space in the array (in bytes)
@@ -496,8 +509,69 @@ void
 DeallocBoundedArray(char *ptr, int size)
 {
     int pgSize = getpagesize();
+    int bytes = divRoundUp(size, pgSize) * pgSize;
+
+    munmap(ptr - pgSize, pgSize * 2 + bytes);
+}
+
+//----------------------------------------------------------------------
+// BoundedArraysGuarded
+// 	Return TRUE if every array from AllocBoundedArray so far really
+//	has unmapped pages on either side, so that running off the end
+//	of one causes a fault right away.
+//----------------------------------------------------------------------
+
+bool
+BoundedArraysGuarded()
+{
+    return guardsWork;
+}
+
+//----------------------------------------------------------------------
+// AllocExecutable
+// 	Return memory that can be both written and executed, for code
+//	generated at run time (see mipsjit.cc).  Returns NULL if the
+//	host won't give us any.
+//
+//	"size" -- amount of space needed (in bytes)
+//----------------------------------------------------------------------
+
+char *
+AllocExecutable(int size)
+{
+    char *ptr = (char *) mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+				MAP_PRIVATE | MAP_ANON, -1, 0);
+
+    if (ptr == (char *) MAP_FAILED)
+	return NULL;
+    return ptr;
+}
+
+//----------------------------------------------------------------------
+// DeallocExecutable
+// 	Give back memory returned by AllocExecutable.
+//
+//	"ptr" -- the memory to be deallocated
+//	"size" -- its size (in bytes)
+//----------------------------------------------------------------------
+
+void
+DeallocExecutable(char *ptr, int size)
+{
+    munmap(ptr, size);
+}
+
+//----------------------------------------------------------------------
+// HostTime
+// 	Return the host's wall-clock time, in seconds.  Only used to
+//	measure how fast the simulation itself runs.
+//----------------------------------------------------------------------
+
+double
+HostTime()
+{
+    struct timeval tv;
 
-    mprotect(ptr - pgSize, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    delete [] (ptr - pgSize);
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
 }
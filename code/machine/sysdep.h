@@ -54,6 +54,15 @@ extern int Random();
 // just beyond either end of the array will cause an error
 extern char *AllocBoundedArray(int size);
 extern void DeallocBoundedArray(char *p, int size);
+extern bool BoundedArraysGuarded();	// is de-referencing beyond either
+					// end really caught?
+
+// Allocate, de-allocate memory that host code can be generated into
+extern char *AllocExecutable(int size);
+extern void DeallocExecutable(char *p, int size);
+
+// Host wall-clock time, in seconds
+extern double HostTime();
 
 // Other C library routines that are used by Nachos.
 // These are assumed to be portable, so we don't include a wrapper.
@@ -48,8 +48,36 @@ Timer::Timer(VoidFunctionPtr timerHandler, int callArg, bool doRandom)
     arg = callArg; 
 
     // schedule the first interrupt from the timer device
-    interrupt->Schedule(TimerHandler, (int) this, TimeOfNextInterrupt(), 
-		TimerInt); 
+    next = interrupt->Schedule(TimerHandler, (int) this,
+		TimeOfNextInterrupt(), TimerInt); 
+}
+
+//----------------------------------------------------------------------
+// Timer::Disable
+//      Stop the timer device: cancel its next interrupt, and don't
+//	schedule any more until it is enabled again.
+//----------------------------------------------------------------------
+
+void
+Timer::Disable()
+{
+    if (next != NULL) {
+	interrupt->Cancel(next);
+	next = NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// Timer::Enable
+//      Start a disabled timer device generating interrupts again.
+//----------------------------------------------------------------------
+
+void
+Timer::Enable()
+{
+    if (next == NULL)
+	next = interrupt->Schedule(TimerHandler, (int) this,
+		TimeOfNextInterrupt(), TimerInt);
 }
 
 //----------------------------------------------------------------------
@@ -62,8 +90,8 @@ void
 Timer::TimerExpired() 
 {
     // schedule the next timer device interrupt
-    interrupt->Schedule(TimerHandler, (int) this, TimeOfNextInterrupt(), 
-		TimerInt);
+    next = interrupt->Schedule(TimerHandler, (int) this,
+		TimeOfNextInterrupt(), TimerInt);
 
     // invoke the Nachos interrupt handler for this device
     (*handler)(arg);
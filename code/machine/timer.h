@@ -11,6 +11,9 @@
 //	In order to introduce some randomness into time-slicing, if "doRandom"
 //	is set, then the interrupt comes after a random number of ticks.
 //
+//	The timer can be turned off while nothing needs it, so that an
+//	idle machine with no other interrupts pending can halt.
+//
 //  DO NOT CHANGE -- part of the machine emulation
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -23,6 +26,8 @@
 #include "copyright.h"
 #include "utility.h"
 
+class PendingInterrupt;
+
 // The following class defines a hardware timer. 
 class Timer {
   public:
@@ -31,6 +36,10 @@ class Timer {
 				// handler "timerHandler" every time slice.
     ~Timer() {}
 
+    void Disable();		// stop generating interrupts
+    void Enable();		// start again, if disabled; the next
+				// interrupt is a full period from now
+
 // Internal routines to the timer emulation -- DO NOT call these
 
     void TimerExpired();	// called internally when the hardware
@@ -43,6 +52,7 @@ class Timer {
     bool randomize;		// set if we need to use a random timeout delay
     VoidFunctionPtr handler;	// timer interrupt handler 
     int arg;			// argument to pass to interrupt handler
+    PendingInterrupt *next;	// the next interrupt; NULL if disabled
 
 };
 
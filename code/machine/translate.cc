@@ -90,27 +90,36 @@ Machine::ReadMem(int addr, int size, int *value)
     int data;
     ExceptionType exception;
     int physicalAddress;
+    unsigned int vpn = (unsigned) addr / PageSize;
+    SoftTLBEntry *cached = &softTlb[vpn % SoftTLBSize];
+    char *where;
     
     DEBUG('a', "Reading VA 0x%x, size %d\n", addr, size);
     
-    exception = Translate(addr, &physicalAddress, size, FALSE);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return FALSE;
+    if (cached->virtualPage == vpn && !(addr & (size - 1))) {
+	cached->entry->use = TRUE;	// the fast path: as Translate would
+	where = cached->host + (unsigned) addr % PageSize;
+    } else {
+	exception = Translate(addr, &physicalAddress, size, FALSE);
+	if (exception != NoException) {
+	    machine->RaiseException(exception, addr);
+	    return FALSE;
+	}
+	where = &mainMemory[physicalAddress];
     }
     switch (size) {
       case 1:
-	data = machine->mainMemory[physicalAddress];
+	data = *where;
 	*value = data;
 	break;
 	
       case 2:
-	data = *(unsigned short *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned short *) where;
 	*value = ShortToHost(data);
 	break;
 	
       case 4:
-	data = *(unsigned int *) &machine->mainMemory[physicalAddress];
+	data = *(unsigned int *) where;
 	*value = WordToHost(data);
 	break;
 
@@ -138,28 +147,42 @@ bool
 Machine::WriteMem(int addr, int size, int value)
 {
     ExceptionType exception;
-    int physicalAddress;
+    int physicalAddress, frame;
+    unsigned int vpn = (unsigned) addr / PageSize;
+    SoftTLBEntry *cached = &softTlb[vpn % SoftTLBSize];
+    char *where;
      
     DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
 
-    exception = Translate(addr, &physicalAddress, size, TRUE);
-    if (exception != NoException) {
-	machine->RaiseException(exception, addr);
-	return FALSE;
+    if (cached->virtualPage == vpn && cached->writable
+					&& !(addr & (size - 1))) {
+	cached->entry->use = TRUE;	// the fast path: as Translate would
+	cached->entry->dirty = TRUE;
+	frame = cached->physicalPage;
+	where = cached->host + (unsigned) addr % PageSize;
+    } else {
+	exception = Translate(addr, &physicalAddress, size, TRUE);
+	if (exception != NoException) {
+	    machine->RaiseException(exception, addr);
+	    return FALSE;
+	}
+	frame = physicalAddress / PageSize;
+	where = &mainMemory[physicalAddress];
     }
+    if (frameDecoded[frame])		// self-modifying code?
+	InvalidateDecodeCache(frame);
     switch (size) {
       case 1:
-	machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+	*where = (unsigned char) (value & 0xff);
 	break;
 
       case 2:
-	*(unsigned short *) &machine->mainMemory[physicalAddress]
+	*(unsigned short *) where
 		= ShortToMachine((unsigned short) (value & 0xffff));
 	break;
       
       case 4:
-	*(unsigned int *) &machine->mainMemory[physicalAddress]
-		= WordToMachine((unsigned int) value);
+	*(unsigned int *) where = WordToMachine((unsigned int) value);
 	break;
 	
       default: ASSERT(FALSE);
@@ -168,6 +191,162 @@ Machine::WriteMem(int addr, int size, int value)
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Machine::CopyFromUser
+//      Copy "size" bytes of virtual memory at "userAddr" into the
+//	kernel buffer "buf", for a system call.  Rather than going
+//	through ReadMem a byte at a time, translate each page once and
+//	copy the part of it we need in one go.
+//
+//   	Returns FALSE if some page couldn't be translated; the bytes
+//	before it have been copied.  Unlike ReadMem, no exception is
+//	raised: the system call reports the error to the user program.
+//
+//	"userAddr" -- the virtual address to copy from
+//	"buf" -- the place to copy to
+//	"size" -- the number of bytes to copy
+//----------------------------------------------------------------------
+
+bool
+Machine::CopyFromUser(int userAddr, char *buf, int size)
+{
+    int physicalAddress, chunk;
+
+    DEBUG('a', "Copying %d bytes from VA 0x%x\n", size, userAddr);
+
+    while (size > 0) {
+	if (TranslateForCopy(userAddr, &physicalAddress, FALSE) != NoException)
+	    return FALSE;
+	chunk = PageSize - physicalAddress % PageSize;	// rest of the page
+	if (chunk > size)
+	    chunk = size;
+	memcpy(buf, &mainMemory[physicalAddress], chunk);
+	userAddr += chunk;
+	buf += chunk;
+	size -= chunk;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::CopyToUser
+//      Copy "size" bytes from the kernel buffer "buf" into virtual
+//	memory at "userAddr", a page at a time, as for CopyFromUser.
+//	Any instructions decoded from the pages written are forgotten,
+//	as WriteMem would.
+//
+//   	Returns FALSE if some page couldn't be translated (or is
+//	read-only); the bytes before it have been copied.
+//
+//	"userAddr" -- the virtual address to copy to
+//	"buf" -- the place to copy from
+//	"size" -- the number of bytes to copy
+//----------------------------------------------------------------------
+
+bool
+Machine::CopyToUser(int userAddr, char *buf, int size)
+{
+    int physicalAddress, chunk;
+
+    DEBUG('a', "Copying %d bytes to VA 0x%x\n", size, userAddr);
+
+    while (size > 0) {
+	if (TranslateForCopy(userAddr, &physicalAddress, TRUE) != NoException)
+	    return FALSE;
+	chunk = PageSize - physicalAddress % PageSize;
+	if (chunk > size)
+	    chunk = size;
+	if (frameDecoded[physicalAddress / PageSize])
+	    InvalidateDecodeCache(physicalAddress / PageSize);
+	memcpy(&mainMemory[physicalAddress], buf, chunk);
+	userAddr += chunk;
+	buf += chunk;
+	size -= chunk;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::CopyStringFromUser
+//      Copy the null-terminated string at virtual address "userAddr"
+//	into the kernel buffer "buf", a page at a time, looking for the
+//	terminating null as we go.
+//
+//   	Returns the length of the string (not counting the null), or -1
+//	if some page couldn't be translated, or there is no null in the
+//	first "maxLength" bytes.
+//
+//	"userAddr" -- the virtual address of the string
+//	"buf" -- the place to copy it to
+//	"maxLength" -- the size of "buf"
+//----------------------------------------------------------------------
+
+int
+Machine::CopyStringFromUser(int userAddr, char *buf, int maxLength)
+{
+    int physicalAddress, chunk, length = 0;
+    char *from, *end;
+
+    DEBUG('a', "Copying string from VA 0x%x\n", userAddr);
+
+    while (length < maxLength) {
+	if (TranslateForCopy(userAddr + length, &physicalAddress, FALSE)
+							!= NoException)
+	    return -1;
+	chunk = PageSize - physicalAddress % PageSize;
+	if (chunk > maxLength - length)
+	    chunk = maxLength - length;
+	from = &mainMemory[physicalAddress];
+	end = (char *) memchr(from, '\0', chunk);
+	if (end != NULL) {			// found the end of the string
+	    memcpy(buf + length, from, end - from + 1);
+	    return length + (end - from);
+	}
+	memcpy(buf + length, from, chunk);
+	length += chunk;
+    }
+    return -1;					// too long
+}
+
+//----------------------------------------------------------------------
+// Machine::TranslateForCopy
+//      Translate a virtual address for CopyFromUser, CopyToUser or
+//	CopyStringFromUser.  If the page isn't in memory, the kernel's
+//	page fault handler is called to bring it in, just as if the
+//	kernel's own reference to it had faulted, and the translation
+//	is tried again; likewise if the page is to be written, but is
+//	shared copy-on-write.  Writing such a page may take two tries
+//	(the copy can leave it missing from the TLB), so we allow three.
+//	Other exceptions are returned, not raised.
+//
+//	A TLB doesn't know how big the address space is, so a miss on a
+//	page outside it is an address error, as the page table would say;
+//	the page fault handler would only try to load the page.
+//
+//	"virtAddr" -- the virtual address to translate
+//	"physAddr" -- the place to store the physical address
+//	"writing" -- if TRUE, the page is to be written
+//----------------------------------------------------------------------
+
+ExceptionType
+Machine::TranslateForCopy(int virtAddr, int *physAddr, bool writing)
+{
+    ExceptionType exception = Translate(virtAddr, physAddr, 1, writing);
+    int tries;
+
+    for (tries = 0; tries < 3; tries++) {
+	if (exception != PageFaultException && exception != ReadOnlyException)
+	    break;
+	if (tlb != NULL && (unsigned) virtAddr / PageSize
+			>= (unsigned) currentThread->space->NumPages())
+	    return AddressErrorException;
+	registers[BadVAddrReg] = virtAddr;
+	ExceptionHandler(exception);
+	exception = Translate(virtAddr, physAddr, 1, writing);
+    }
+    return exception;
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	Translate a virtual address into a physical address, using 
@@ -177,6 +356,13 @@ Machine::WriteMem(int addr, int size, int value)
 //	address in "physAddr".  If there was an error, returns the type
 //	of the exception.
 //
+//	Successful page table translations are remembered in the soft
+//	TLB, which we check first.  With a TLB, only the set the page
+//	hashes to is searched, for an entry of the current address space;
+//	hits and misses are counted, and hits time-stamped for LRU.  (The
+//	block engines call us once per basic block for its instructions,
+//	and count the rest afterwards; see Machine::CountBlockFetches.)
+//
 //	"virtAddr" -- the virtual address to translate
 //	"physAddr" -- the place to store the physical address
 //	"size" -- the amount of memory being read or written
@@ -186,10 +372,11 @@ Machine::WriteMem(int addr, int size, int value)
 ExceptionType
 Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 {
-    int i;
+    int i, set;
     unsigned int vpn, offset;
     TranslationEntry *entry;
     unsigned int pageFrame;
+    SoftTLBEntry *cached;
 
     DEBUG('a', "\tTranslate 0x%x, %s: ", virtAddr, writing ? "write" : "read");
 
@@ -198,15 +385,26 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	DEBUG('a', "alignment problem at %d, size %d!\n", virtAddr, size);
 	return AddressErrorException;
     }
-    
-    // we must have either a TLB or a page table, but not both!
-    ASSERT(tlb == NULL || pageTable == NULL);	
-    ASSERT(tlb != NULL || pageTable != NULL);	
 
 // calculate the virtual page number, and offset within the page,
 // from the virtual address
     vpn = (unsigned) virtAddr / PageSize;
     offset = (unsigned) virtAddr % PageSize;
+
+// a translation we've done before?
+    cached = &softTlb[vpn % SoftTLBSize];
+    if (cached->virtualPage == vpn && (cached->writable || !writing)) {
+	cached->entry->use = TRUE;
+	if (writing)
+	    cached->entry->dirty = TRUE;
+	*physAddr = cached->physicalPage * PageSize + offset;
+	DEBUG('a', "phys addr = 0x%x\n", *physAddr);
+	return NoException;
+    }
+    
+    // we must have either a TLB or a page table, but not both!
+    ASSERT(tlb == NULL || pageTable == NULL);	
+    ASSERT(tlb != NULL || pageTable != NULL);	
     
     if (tlb == NULL) {		// => page table => vpn is index into table
 	if (vpn >= pageTableSize) {
@@ -220,17 +418,22 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	}
 	entry = &pageTable[vpn];
     } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && (tlb[i].virtualPage == vpn)) {
+	set = TLBSet(vpn, currentAsid);
+        for (entry = NULL, i = set; i < set + tlbWays; i++)
+    	    if (tlb[i].valid && (tlb[i].virtualPage == vpn)
+					&& (tlb[i].asid == currentAsid)) {
 		entry = &tlb[i];			// FOUND!
 		break;
 	    }
 	if (entry == NULL) {				// not found
     	    DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
+	    stats->numTLBMisses++;
     	    return PageFaultException;		// really, this is a TLB fault,
 						// the page may be in memory,
 						// but not in the TLB
 	}
+	stats->numTLBHits++;
+	tlbLastUse[i] = stats->numTLBHits;
     }
 
     if (entry->readOnly && writing) {	// trying to write to a read-only page
@@ -251,5 +454,53 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
     DEBUG('a', "phys addr = 0x%x\n", *physAddr);
+
+    if (tlb != NULL)
+	return NoException;
+    cached->virtualPage = vpn;		// remember it for next time
+    cached->physicalPage = pageFrame;
+    cached->host = &mainMemory[pageFrame * PageSize];
+    cached->writable = !entry->readOnly;
+    cached->entry = entry;
     return NoException;
 }
+
+//----------------------------------------------------------------------
+// Machine::FlushSoftTLB
+// 	Forget every translation cached by Translate.  Must be called
+//	whenever the page table or the TLB changes, other than to clear
+//	use or dirty bits -- including switching to another page table.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushSoftTLB()
+{
+    int i;
+
+    for (i = 0; i < SoftTLBSize; i++)
+	softTlb[i].virtualPage = (unsigned) -1;
+}
+
+//----------------------------------------------------------------------
+// Machine::TLBSet
+// 	Return the first entry of the set of the TLB that a page may be
+//	cached in.  The set is picked by hashing the page number and the
+//	address space id, so that neighbouring pages, and the same page
+//	of different address spaces (which all start at 0), go in
+//	different sets.
+//
+//	"vpn" -- the virtual page number
+//	"asid" -- the address space id it belongs to
+//----------------------------------------------------------------------
+
+int
+Machine::TLBSet(unsigned int vpn, int asid)
+{
+    unsigned int numSets = tlbSize / tlbWays;
+    unsigned int hash;
+
+    if (numSets == 1)			// fully associative
+	return 0;
+    hash = (vpn ^ ((unsigned) asid << 8)) * 0x9e3779b1;
+    return ((hash >> 16) % numSets) * tlbWays;
+}
@@ -40,6 +40,29 @@ class TranslationEntry {
 			// page is referenced or modified.
     bool dirty;         // This bit is set by the hardware every time the
 			// page is modified.
+    int asid;		// In a TLB entry, the address space the
+			// translation belongs to.  Unused in page tables.
+};
+
+// The simulator also keeps a small cache of recently used translations,
+// the "soft TLB", so that most memory references can skip the checks
+// and lookups in Machine::Translate, and go straight to the page in
+// "mainMemory".  It is part of the simulation, not of the simulated
+// hardware: user programs can't tell it is there, but the kernel must
+// call Machine::FlushSoftTLB whenever it changes a translation that
+// may have been used.  Use and dirty bits are still set on every
+// reference, so the kernel may clear those at any time.  It only caches
+// page table translations; with a TLB, every reference is looked up in
+// the TLB itself.
+
+class SoftTLBEntry {
+  public:
+    unsigned int virtualPage;	// the page cached here, or -1 if none
+    int physicalPage;		// the frame it is mapped to
+    char *host;			// where that frame is in "mainMemory"
+    bool writable;		// if FALSE, stores take the slow path
+    TranslationEntry *entry;	// the page table or TLB entry whose use
+				// and dirty bits we set
 };
 
 #endif
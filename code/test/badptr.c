@@ -0,0 +1,41 @@
+/* badptr.c
+ *	Simple program to test system calls given pointers outside the
+ *	address space: past its end, and negative.  Each call should
+ *	fail (the kernel prints why), rather than bring down the kernel,
+ *	with or without a TLB.
+ *
+ *		nachos -x ../test/badptr
+ *
+ *	should print "all calls returned", then halt.
+ */
+
+#include "syscall.h"
+
+#define PastTheEnd	((char *) 0x10000000)	/* far past any program */
+#define Negative	((char *) -4096)
+
+int
+main()
+{
+    char buffer[16];
+    int fd;
+
+    Create(PastTheEnd);
+    Create(Negative);
+    if (Open(PastTheEnd) != 0)
+	Print("Open of a bad name succeeded\n", 0);
+    Mkdir(Negative);
+    Print(PastTheEnd, 0);
+
+    Create("badptr.tmp");
+    fd = Open("badptr.tmp");
+    Write(PastTheEnd, sizeof(buffer), fd);
+    Write(Negative, sizeof(buffer), fd);
+    if (Read(PastTheEnd, sizeof(buffer), fd) >= 0)
+	Print("Read into a bad buffer succeeded\n", 0);
+    Close(fd);
+
+    Print("all calls returned\n", 0);
+    Halt();
+    /* not reached */
+}
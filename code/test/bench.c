@@ -0,0 +1,50 @@
+/* bench.c
+ *	Compute-bound test program, for comparing how fast the different
+ *	ways of running user code go.  Run it with each of
+ *
+ *		nachos -x ../test/bench
+ *		nachos -bb -x ../test/bench
+ *		nachos -jit -x ../test/bench
+ *
+ *	and compare the "Host:" line printed when Nachos halts.  The
+ *	simulated statistics ("Ticks:") should be identical.
+ *
+ *	Unlike sort and matmult, the data fits in physical memory, so
+ *	it runs without virtual memory.
+ */
+
+#include "syscall.h"
+
+#define N	64		/* size of the array to sort */
+#define Rounds	20		/* times to sort it */
+
+int
+main()
+{
+    int a[N];
+    int i, j, r, tmp, seed, sum;
+
+    seed = 1;
+    sum = 0;
+    for (r = 0; r < Rounds; r++) {
+	/* fill the array with pseudo-random numbers */
+	for (i = 0; i < N; i++) {
+	    seed = seed * 1103515245 + 12345;
+	    a[i] = (seed >> 8) & 0xffff;
+	}
+
+	/* insertion sort */
+	for (i = 1; i < N; i++) {
+	    tmp = a[i];
+	    for (j = i; j > 0 && a[j - 1] > tmp; j--)
+		a[j] = a[j - 1];
+	    a[j] = tmp;
+	}
+
+	/* checksum, with some shifts, multiplies and divides */
+	for (i = 0; i < N; i++)
+	    sum += (a[i] * (i + 1)) / 3 + (a[i] >> 2) + ((unsigned) sum >> 31);
+    }
+    Halt();
+    /* not reached */
+}
@@ -0,0 +1,72 @@
+/* fork.c
+ *	Simple program to test the Fork system call.  Parent and child
+ *	each write their own values over an array they shared when the
+ *	child was forked, so each gets copies of the pages it writes,
+ *	and each prints what it sees.
+ *
+ *	The child says it is done through a file, since memory is no
+ *	longer shared once written: the parent yields until the file
+ *	says so, then prints, and halts.
+ *
+ *		nachos -x ../test/fork
+ *
+ *	prints the counts of pages copied on write when it halts.  To
+ *	time Fork itself, against the pages in memory, try
+ *
+ *		nachos -fb ../test/matmult
+ */
+
+#include "syscall.h"
+
+#define Size	1024		/* ints in the array: 8 pages */
+#define Flag	"fork.flag"	/* holds 'y' once the child is done */
+
+int array[Size];
+
+static void
+SetFlag(char value)
+{
+    OpenFileId fd = Open(Flag);
+
+    Write(&value, 1, fd);
+    Close(fd);
+}
+
+static char
+GetFlag()
+{
+    OpenFileId fd = Open(Flag);
+    char value = 'n';
+
+    Read(&value, 1, fd);
+    Close(fd);
+    return value;
+}
+
+int
+main()
+{
+    int i, sum;
+    SpaceId child;
+
+    Create(Flag);
+    SetFlag('n');
+    for (i = 0; i < Size; i++)
+	array[i] = 1;
+    child = Fork();
+    for (i = 0; i < Size; i++)
+	array[i] = (child == 0) ? 2 : 3;
+    sum = 0;
+    for (i = 0; i < Size; i++)
+	sum += array[i];
+    if (child == 0) {
+	Print("child: sum %d\n", sum);
+	SetFlag('y');
+	Exit(0);
+    }
+    while (GetFlag() != 'y')
+	Yield();
+    Print("parent: sum %d\n", sum);
+    Halt();
+    /* not reached */
+}
@@ -0,0 +1,27 @@
+/* sleep.c
+ *	Simple program to test the Sleep system call.  Sleeps for a
+ *	longer time each round, printing as it wakes up, then halts.
+ *
+ *		nachos -d t -x ../test/sleep
+ *
+ *	shows each sleep, and the time it ends at.
+ */
+
+#include "syscall.h"
+
+#define Rounds	5		/* times to sleep */
+
+int
+main()
+{
+    int i, ticks;
+
+    ticks = 100;
+    for (i = 0; i < Rounds; i++) {
+	Sleep(ticks);
+	Print("slept for %d ticks\n", ticks);
+	ticks *= 10;
+    }
+    Halt();
+    /* not reached */
+}
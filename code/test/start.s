@@ -138,6 +138,14 @@ Print:
 	j	$31
 	.end Print
 
+	.globl Sleep
+	.ent Sleep
+Sleep:
+	addiu $2,$0,SC_Sleep
+	syscall
+	j	$31
+	.end Sleep
+
 /*	.globl Mkdir
 	.ent Mkdir
 Mkdir:
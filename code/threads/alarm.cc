@@ -0,0 +1,178 @@
+// alarm.cc
+//	Routines to put threads to sleep for a while, using the hardware
+//	timer to wake them up.
+//
+//	A sleeper is woken at the first timer interrupt at or after the
+//	time it asked for, so it may sleep for a timer period or so
+//	longer, but never less.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "alarm.h"
+#include "system.h"
+
+// dummy function because C++ does not allow pointers to member functions
+static void AlarmHandler(int arg)
+{ Alarm *p = (Alarm *)arg; p->CallBack(); }
+
+//----------------------------------------------------------------------
+// Alarm::Alarm
+// 	Initialize the alarm clock, with an empty wheel.  The timer
+//	isn't started until the first thread goes to sleep.
+//----------------------------------------------------------------------
+
+Alarm::Alarm()
+{
+    int level, slot;
+
+    timer = NULL;
+    now = 0;
+    lastTick = 0;
+    numSleepers = 0;
+    for (level = 0; level < WheelLevels; level++)
+	for (slot = 0; slot < WheelSlots; slot++)
+	    wheel[level][slot] = NULL;
+}
+
+//----------------------------------------------------------------------
+// Alarm::~Alarm
+// 	Shut down the alarm clock.  Any threads still asleep stay so.
+//----------------------------------------------------------------------
+
+Alarm::~Alarm()
+{
+    if (timer != NULL)
+	timer->Disable();
+    delete timer;
+}
+
+//----------------------------------------------------------------------
+// Alarm::SleepUntil
+// 	Put the current thread to sleep until a given simulated time.
+//	Returns right away if that time has already come.
+//
+//	"when" is the value of stats->totalTicks to wake up at
+//----------------------------------------------------------------------
+
+void
+Alarm::SleepUntil(int when)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    AlarmEntry entry;
+
+    if (when > stats->totalTicks) {
+	if (timer == NULL) {
+	    timer = new Timer(AlarmHandler, (int) this, FALSE);
+	    lastTick = stats->totalTicks;
+	} else if (numSleepers == 0) {
+	    timer->Enable();
+	    lastTick = stats->totalTicks;
+	}
+	DEBUG('t', "Thread \"%s\" sleeping until time %d\n",
+	    currentThread->getName(), when);
+	entry.thread = currentThread;
+	entry.when = when;
+	entry.expires = now + divRoundUp(when - lastTick, TimerTicks);
+	Insert(&entry);
+	numSleepers++;
+	currentThread->Sleep(BlockedSleep);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Insert
+// 	Put an entry in the slot for the interrupt it expires at: on the
+//	lowest level that reaches that far ahead.  Entries further ahead
+//	than the whole wheel go in the furthest slot, and are put back
+//	in again from there.
+//
+//	"entry" is the sleeper to put in the wheel
+//----------------------------------------------------------------------
+
+void
+Alarm::Insert(AlarmEntry *entry)
+{
+    int delta, level, slot;
+    int expires = entry->expires;
+
+    ASSERT(expires >= now);		// "now" itself only when cascading,
+					// just before that slot is emptied
+    delta = expires - now;
+    for (level = 0; level < WheelLevels - 1; level++)
+	if (delta < (1 << (WheelBits * (level + 1))))
+	    break;
+    if (delta >= (1 << (WheelBits * WheelLevels)))
+	expires = now + (1 << (WheelBits * WheelLevels)) - 1;
+    slot = (expires >> (WheelBits * level)) & (WheelSlots - 1);
+    entry->next = wheel[level][slot];
+    wheel[level][slot] = entry;
+}
+
+//----------------------------------------------------------------------
+// Alarm::Cascade
+// 	Take the entries out of the current slot of a level, and put
+//	them back in the wheel; they're close enough now to go in a
+//	lower level.
+//
+//	"level" is the level to cascade, 1 or more
+//----------------------------------------------------------------------
+
+void
+Alarm::Cascade(int level)
+{
+    int slot = (now >> (WheelBits * level)) & (WheelSlots - 1);
+    AlarmEntry *entry = wheel[level][slot];
+    AlarmEntry *next;
+
+    wheel[level][slot] = NULL;
+    for (; entry != NULL; entry = next) {
+	next = entry->next;
+	Insert(entry);
+    }
+}
+
+//----------------------------------------------------------------------
+// Alarm::CallBack
+// 	Called on each timer interrupt, with interrupts disabled.  Bring
+//	the wheel up to date, and wake up everyone in the current slot
+//	whose time has come; anyone whose time hasn't (because they asked
+//	for longer than the wheel covers) goes back in.
+//
+//	Turns the timer off once no one is asleep.
+//----------------------------------------------------------------------
+
+void
+Alarm::CallBack()
+{
+    int level, slot;
+    AlarmEntry *entry, *next;
+
+    now++;
+    lastTick = stats->totalTicks;
+    for (level = 1; level < WheelLevels; level++) {
+	if ((now & ((1 << (WheelBits * level)) - 1)) != 0)
+	    break;			// level - 1 hasn't wrapped around
+	Cascade(level);
+    }
+
+    slot = now & (WheelSlots - 1);
+    entry = wheel[0][slot];
+    wheel[0][slot] = NULL;
+    for (; entry != NULL; entry = next) {
+	next = entry->next;		// the entry is gone once it wakes
+	if (entry->when > stats->totalTicks) {
+	    entry->expires = now + divRoundUp(entry->when - lastTick,
+		TimerTicks);
+	    Insert(entry);
+	} else {
+	    numSleepers--;
+	    scheduler->ReadyToRun(entry->thread);
+	}
+    }
+    if (numSleepers == 0)
+	timer->Disable();
+}
@@ -0,0 +1,72 @@
+// alarm.h
+//	Data structures for the alarm clock: a service that lets threads
+//	sleep until a given time (see Thread::SleepFor and SleepUntil).
+//
+//	The sleepers are kept in a hierarchical timer wheel, driven by a
+//	hardware timer.  Level 0 has a slot for each of the next
+//	WheelSlots timer interrupts; each slot of level 1 covers WheelSlots
+//	interrupts after that, and so on.  Each interrupt wakes up all the
+//	sleepers in the current level 0 slot, and every WheelSlots
+//	interrupts, the sleepers in the next slot of level 1 are spread
+//	out over level 0 (and so on up).  So putting a thread to sleep,
+//	and each interrupt, take time proportional to the number of
+//	threads woken up, not the number asleep.
+//
+//	The timer is only running while someone is asleep, so that it
+//	doesn't keep an otherwise idle Nachos from halting.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "thread.h"
+#include "timer.h"
+
+#define WheelBits	6
+#define WheelSlots	(1 << WheelBits)	// slots per level
+#define WheelLevels	4			// so the wheel covers
+						// 2^24 timer interrupts
+
+// A sleeping thread.  It lives on the thread's own stack, for as long
+// as the thread is asleep.
+
+class AlarmEntry {
+  public:
+    Thread *thread;		// the sleeper
+    int when;			// the simulated time to wake it up
+    int expires;		// the timer interrupt to wake it up at
+    AlarmEntry *next;		// next in the same slot
+};
+
+// The following class defines the alarm clock.
+
+class Alarm {
+  public:
+    Alarm();			// initialize the alarm clock, with no
+				// one asleep
+    ~Alarm();
+
+    void SleepUntil(int when);	// put the current thread to sleep until
+				// stats->totalTicks reaches "when"
+
+    void CallBack();		// called by the timer on each interrupt
+
+  private:
+    Timer *timer;		// the hardware timer; NULL until needed
+    int now;			// timer interrupts so far
+    int lastTick;		// simulated time of the latest one (or of
+				// when the timer was enabled)
+    int numSleepers;		// threads asleep
+    AlarmEntry *wheel[WheelLevels][WheelSlots];
+
+    void Insert(AlarmEntry *entry);	// put "entry" in its slot
+    void Cascade(int level);	// spread out the current slot of "level"
+				// over the levels below
+};
+
+#endif // ALARM_H
@@ -0,0 +1,81 @@
+// freelist.cc
+//	Routines to recycle small objects of one size.
+//
+//	Objects are reused last in, first out, since the most recently
+//	freed object is the most likely to still be in the host's cache.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "freelist.h"
+
+int FreeList::totalSlabs = 0;
+
+//----------------------------------------------------------------------
+// FreeList::FreeList
+// 	Initialize an empty free list.  Objects are rounded up to a
+//	multiple of 8 bytes, so that anything can be stored in them.
+//
+//	"objectSize" is the size of each object, in bytes
+//	"objectsPerSlab" is how many objects to allocate at a time
+//----------------------------------------------------------------------
+
+FreeList::FreeList(int objectSize, int objectsPerSlab)
+{
+    ASSERT(objectSize > 0 && objectsPerSlab > 0);
+    if (objectSize < (int) sizeof(FreeObject))
+	objectSize = sizeof(FreeObject);
+    size = divRoundUp(objectSize, 8) * 8;
+    perSlab = objectsPerSlab;
+    free = NULL;
+    numSlabs = 0;
+}
+
+//----------------------------------------------------------------------
+// FreeList::Alloc
+// 	Return an object: the one most recently freed, if any.  If
+//	there isn't one, allocate a new slab, and put all its objects
+//	on the free list first.
+//----------------------------------------------------------------------
+
+void *
+FreeList::Alloc()
+{
+    FreeObject *object;
+    char *slab;
+    int i;
+
+    if (free == NULL) {
+	slab = new char[size * perSlab];
+	for (i = perSlab - 1; i >= 0; i--) {
+	    object = (FreeObject *) (slab + i * size);
+	    object->next = free;
+	    free = object;
+	}
+	numSlabs++;
+	totalSlabs++;
+    }
+    object = free;
+    free = object->next;
+    return (void *) object;
+}
+
+//----------------------------------------------------------------------
+// FreeList::Free
+// 	Put an object back on the free list, for the next Alloc.
+//
+//	"object" is the object, from an earlier Alloc on this list
+//----------------------------------------------------------------------
+
+void
+FreeList::Free(void *object)
+{
+    FreeObject *freed = (FreeObject *) object;
+
+    if (freed == NULL)
+	return;
+    freed->next = free;
+    free = freed;
+}
@@ -0,0 +1,62 @@
+// freelist.h
+//	Data structures for recycling small objects of one size, such
+//	as list elements and pending interrupts.
+//
+//	Objects are carved out of slabs of memory allocated a few dozen
+//	at a time, and when an object is freed it goes on a free list,
+//	to be handed out again by the next Alloc.  Once enough slabs
+//	have been allocated for the most objects ever in use at once,
+//	allocating and freeing an object never touches the heap; it is
+//	just a couple of pointer moves.  Slabs are never given back.
+//
+//	A class uses a free list by defining operator new and operator
+//	delete to call Alloc and Free on a static FreeList, so that
+//	code that uses "new" and "delete" on it doesn't change.
+//
+//	NOTE: Mutual exclusion must be provided by the caller, as for
+//	the lists the objects are used in.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FREELIST_H
+#define FREELIST_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define FreeListSlabSize	64	// default objects per slab
+
+// An object on a free list; its first word links it to the next.
+
+class FreeObject {
+  public:
+    FreeObject *next;
+};
+
+// The following class defines a free list of objects, each "size" bytes.
+
+class FreeList {
+  public:
+    FreeList(int objectSize, int objectsPerSlab = FreeListSlabSize);
+				// initialize an empty free list
+
+    void *Alloc();		// an object, from the free list if
+				// possible, otherwise a new slab
+    void Free(void *object);	// put "object" back on the free list
+
+    int NumSlabs() { return numSlabs; }
+    static int TotalSlabs() { return totalSlabs; } // slabs allocated
+				// so far, by all the free lists
+
+  private:
+    int size;			// bytes in each object
+    int perSlab;		// objects in each slab
+    FreeObject *free;		// objects ready for reuse
+    int numSlabs;		// slabs allocated for this list
+
+    static int totalSlabs;	// and for all of them
+};
+
+#endif // FREELIST_H
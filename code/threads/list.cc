@@ -5,7 +5,9 @@
 // 	A "ListElement" is allocated for each item to be put on the
 //	list; it is de-allocated when the item is removed. This means
 //      we don't need to keep a "next" pointer in every object we
-//      want to put on a list.
+//      want to put on a list.  ListElements come from a free list,
+//	so once there have been as many on lists as there will ever be
+//	at once, putting an item on a list doesn't touch the heap.
 // 
 //     	NOTE: Mutual exclusion must be provided by the caller.
 //  	If you want a synchronized list, you must use the routines 
@@ -18,6 +20,7 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "freelist.h"
 
 //----------------------------------------------------------------------
 // ListElement::ListElement
@@ -35,6 +38,40 @@ ListElement::ListElement(void *itemPtr, int sortKey)
      next = NULL;	// assume we'll put it at the end of the list 
 }
 
+//----------------------------------------------------------------------
+// ListElements
+// 	Return the free list of ListElements.  It is constructed on first
+//	use, since lists are used by other files' static initializers
+//	(e.g., to create a Semaphore with profiling on).
+//----------------------------------------------------------------------
+
+static FreeList *
+ListElements()
+{
+    static FreeList elements(sizeof(ListElement));
+
+    return &elements;
+}
+
+//----------------------------------------------------------------------
+// ListElement::operator new, ListElement::operator delete
+// 	Allocate and de-allocate list elements from their free list,
+//	rather than the heap.
+//----------------------------------------------------------------------
+
+void *
+ListElement::operator new(size_t size)
+{
+    ASSERT(size == sizeof(ListElement));
+    return ListElements()->Alloc();
+}
+
+void
+ListElement::operator delete(void *element)
+{
+    ListElements()->Free(element);
+}
+
 //----------------------------------------------------------------------
 // List::List
 //	Initialize a list, empty to start with.
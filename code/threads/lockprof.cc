@@ -0,0 +1,169 @@
+// lockprof.cc
+//	Routines to profile contention on the synchronization primitives.
+//
+//	All of these are called with interrupts disabled, from inside
+//	the primitives, so they don't need any locking of their own.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "lockprof.h"
+
+#ifdef LOCK_PROFILE
+
+#include "system.h"
+
+static List *profiles = NULL;	// every profile, in order of creation
+
+//----------------------------------------------------------------------
+// SynchProfile::SynchProfile
+// 	Initialize the profile of a primitive, with nothing counted yet.
+//
+//	"kindName" is the kind of primitive
+//	"debugName" is its name
+//----------------------------------------------------------------------
+
+SynchProfile::SynchProfile(char *kindName, char *debugName)
+{
+    int i;
+
+    kind = kindName;
+    name = debugName;
+    numAcquires = numContended = totalWait = maxWait = 0;
+    numHolds = totalHold = maxHold = 0;
+    for (i = 0; i < ProfileTopWaiters; i++) {
+	top[i].name = NULL;
+	top[i].tid = -1;
+	top[i].ticks = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Find
+// 	Return the profile shared by the primitives of a kind with a
+//	name, creating it the first time.  Only called when a primitive
+//	is created, so it just looks through all the profiles.
+//
+//	"kind" is the kind of primitive
+//	"name" is its name
+//----------------------------------------------------------------------
+
+SynchProfile *
+SynchProfile::Find(char *kind, char *name)
+{
+    ListElement *element;
+    SynchProfile *profile;
+
+    if (profiles == NULL)
+	profiles = new List;
+    for (element = profiles->Front(); element != NULL; element = element->next) {
+	profile = (SynchProfile *) element->item;
+	if (!strcmp(profile->kind, kind) && !strcmp(profile->name, name))
+	    return profile;
+    }
+    profile = new SynchProfile(kind, name);
+    profiles->Append((void *) profile);
+    return profile;
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Waited
+// 	Count an acquisition that had to wait, and remember the thread
+//	that waited if it waited longer than the ones in "top".  Usually
+//	that is the current thread, but a lock handed to a thread is
+//	counted by the thread handing it over.
+//
+//	"since" is the tick when it started waiting
+//	"thread" is the thread that waited
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Waited(int since)
+{
+    Waited(since, currentThread);
+}
+
+void
+SynchProfile::Waited(int since, Thread *thread)
+{
+    int ticks = stats->totalTicks - since;
+    int i;
+
+    numAcquires++;
+    numContended++;
+    totalWait += ticks;
+    if (ticks > maxWait)
+	maxWait = ticks;
+    if (ticks <= top[ProfileTopWaiters - 1].ticks)
+	return;
+    for (i = ProfileTopWaiters - 1; i > 0 && top[i - 1].ticks < ticks; i--)
+	top[i] = top[i - 1];
+    top[i].name = thread->getName();
+    top[i].tid = thread->getTid();
+    top[i].ticks = ticks;
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Held
+// 	Count a lock being released.
+//
+//	"since" is the tick when it was acquired
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Held(int since)
+{
+    int ticks = stats->totalTicks - since;
+
+    numHolds++;
+    totalHold += ticks;
+    if (ticks > maxHold)
+	maxHold = ticks;
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Print
+// 	Print one profile, and its longest waits.
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Print()
+{
+    int i;
+
+    printf("%-9s %-16.16s %7d %7d %9d %7d", kind, name, numAcquires,
+	numContended, totalWait, maxWait);
+    if (numHolds > 0)
+	printf(" %9d %7d", totalHold, maxHold);
+    printf("\n");
+    for (i = 0; i < ProfileTopWaiters && top[i].name != NULL; i++)
+	printf("%26s (tid %d) waited %d ticks\n", top[i].name, top[i].tid,
+	    top[i].ticks);
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::PrintAll
+// 	Print the profile of every primitive that has been used.
+//----------------------------------------------------------------------
+
+void
+SynchProfile::PrintAll()
+{
+    ListElement *element;
+    SynchProfile *profile;
+
+    if (profiles == NULL)
+	return;
+    printf("Synchronization profile (ticks):\n");
+    printf("%-9s %-16s %7s %7s %9s %7s %9s %7s\n", "Kind", "Name",
+	"Acquire", "Waited", "WaitTotal", "WaitMax", "HoldTotal", "HoldMax");
+    for (element = profiles->Front(); element != NULL; element = element->next) {
+	profile = (SynchProfile *) element->item;
+	if (profile->numAcquires > 0)
+	    profile->Print();
+    }
+}
+
+#endif // LOCK_PROFILE
@@ -0,0 +1,80 @@
+// lockprof.h
+//	Data structures for profiling contention on the synchronization
+//	primitives (see synch.h).
+//
+//	For each kind of primitive and name, we count how many times it
+//	was acquired (P, Acquire, or Wait) and how many of those had to
+//	wait; the total and longest waits, in simulated ticks; for locks,
+//	the total and longest time held; and the threads that waited the
+//	longest.  Primitives with the same kind and name share a profile,
+//	so one created and deleted over and over shows up as one line.
+//	The profiles are printed when Nachos halts.
+//
+//	Profiling is only compiled in with -DLOCK_PROFILE (add it to
+//	DEFINES in the Makefile).  Otherwise everything in PROFILE(...)
+//	disappears, and the primitives are exactly as fast as before.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef LOCKPROF_H
+#define LOCKPROF_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Thread;
+
+#ifdef LOCK_PROFILE
+#define PROFILE(code)	code
+#else
+#define PROFILE(code)
+#endif
+
+#ifdef LOCK_PROFILE
+
+#define ProfileTopWaiters 3	// longest waits kept for each profile
+
+// One of the longest waits.
+
+class ProfileWaiter {
+  public:
+    char *name;			// the thread that waited
+    int tid;
+    int ticks;			// for how long
+};
+
+// The following class defines the profile of a (named) primitive.
+
+class SynchProfile {
+  public:
+    static SynchProfile *Find(char *kind, char *name);
+				// the profile for "kind" "name", created
+				// if there isn't one yet
+    static void PrintAll();	// print every profile in use
+
+    void Acquired() { numAcquires++; }	// got it without waiting
+    void Waited(int since);	// got it, after waiting from tick "since"
+    void Waited(int since, Thread *thread); // "thread" got it, after
+				// waiting, while someone else runs
+    void Held(int since);	// released it, held since tick "since"
+
+    void Print();
+
+  private:
+    SynchProfile(char *kindName, char *debugName);
+
+    char *kind;			// "Semaphore", "Lock", ...
+    char *name;			// the primitive's debugging name
+    int numAcquires;		// times acquired
+    int numContended;		// ... after waiting
+    int totalWait, maxWait;	// ticks spent waiting
+    int numHolds;		// times released
+    int totalHold, maxHold;	// ticks held, for locks
+    ProfileWaiter top[ProfileTopWaiters]; // longest waits, longest first
+};
+
+#endif // LOCK_PROFILE
+
+#endif // LOCKPROF_H
@@ -8,8 +8,11 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
+// Usage: nachos -d <debugflags> -rs <random seed #> -sched <policy>
+//		-stacks <# stacks> -tstats <stats file>
+//		-s -bb -jit -x <nachos file> -c <consoleIn> <consoleOut>
+//		-vm <policy> -tlb <# entries> -tlbways <# ways>
+//		-tlbrepl <policy>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -m <machine id>
@@ -18,13 +21,37 @@
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -sched chooses how threads are scheduled: fifo (the default),
+//	rr (round robin), priority (static priority), mlfq
+//	(multilevel feedback queue), or cfs (completely fair)
+//    -stacks sets how many unused thread stacks are kept for reuse
+//    -tstats writes each thread's statistics (CPU time, scheduling
+//	latency, time blocked, ...) to a file, as JSON if its name ends
+//	in .json, otherwise CSV
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -bb runs user programs on the basic-block threaded interpreter
+//    -jit is like -bb, but also translates frequently run blocks into
+//	host machine code (x86 hosts only)
 //    -x runs a user program
+//    -fb times forking a user program's address space, copy-on-write,
+//	against how many of its pages are in memory
 //    -c tests the console
 //
+//  VM
+//    -vm chooses how pages are picked for eviction when memory is full:
+//	fifo, clock (the default), eclock (enhanced clock) or aging
+//
+//  USE_TLB
+//    -tlb sets the number of TLB entries (4 by default)
+//    -tlbways sets how many entries are in each set of the TLB; a page
+//	may only be in the set its number hashes to (by default, the
+//	TLB is fully associative)
+//    -tlbrepl chooses which entry of a full set a refill replaces:
+//	random (the default), fifo or lru
+//
 //  FILESYS
 //    -f causes the physical disk to be formatted
 //    -cp copies a file from UNIX to Nachos
@@ -62,6 +89,7 @@ extern int testnum;
 extern void ThreadTest(int), Copy(char *unixFile, char *nachosFile);
 extern void Print(char *file), PerformanceTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out), SynchConsoleTest(char *in, char *out);
+extern void ForkBenchmark(char *file);
 extern void MailTest(int networkID);
 extern void FakeSocketTest(int networkID);
 
@@ -114,6 +142,10 @@ main(int argc, char **argv)
 	//testBarrier();
 	//producer_consumer_semaphore();
 	//producer_consumer_cv_lock();
+	//lock_handoff_benchmark();
+	//rwlock_benchmark();
+	//context_switch_benchmark();
+	//semaphore_order_test();
 
 
 
@@ -143,6 +175,10 @@ main(int argc, char **argv)
 			ASSERT(count > 1);
 			StartProcess(*(argValue + 1));
 			argCount = 2;
+		} else if (!strcmp(*argValue, "-fb")) {	// time Fork
+			ASSERT(count > 1);
+			ForkBenchmark(*(argValue + 1));
+			argCount = 2;
 		} else if (!strcmp(*argValue, "-c")) {      // test the console
 			if (count == 1) {
 //				char *input = "Test console input.";
@@ -0,0 +1,211 @@
+// ordtree.cc
+//	Routines to manage an ordered tree (a treap).
+//
+//	Insert puts the new node where a binary search tree would, as a
+//	leaf, then rotates it up until its parent's weight is no greater
+//	than its own.  The node with the smallest key is the leftmost one,
+//	which has no left child, so RemoveMin just replaces it with its
+//	right child -- that keeps both the order and the heap property.
+//
+//	The weights come from a private generator, rather than Random(),
+//	so that using the tree doesn't change the sequence of random
+//	numbers seen by the rest of Nachos (e.g., for -rs).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "ordtree.h"
+#include "freelist.h"
+
+static FreeList nodes(sizeof(TreeNode));	// recycled TreeNodes
+
+//----------------------------------------------------------------------
+// TreeNode::TreeNode
+// 	Initialize a tree node, so it can be inserted into a tree.
+//
+//	"itemPtr" is the item to put in the tree
+//	"sortKey" is its key
+//	"nodeWeight" is its weight, for keeping the tree balanced
+//----------------------------------------------------------------------
+
+TreeNode::TreeNode(void *itemPtr, int sortKey, unsigned int nodeWeight)
+{
+    item = itemPtr;
+    key = sortKey;
+    weight = nodeWeight;
+    left = right = NULL;
+}
+
+//----------------------------------------------------------------------
+// TreeNode::operator new, TreeNode::operator delete
+// 	Allocate and de-allocate tree nodes from their free list, rather
+//	than the heap, since the scheduler inserts one per context switch.
+//----------------------------------------------------------------------
+
+void *
+TreeNode::operator new(size_t size)
+{
+    ASSERT(size == sizeof(TreeNode));
+    return nodes.Alloc();
+}
+
+void
+TreeNode::operator delete(void *node)
+{
+    nodes.Free(node);
+}
+
+//----------------------------------------------------------------------
+// OrderedTree::OrderedTree
+// 	Initialize an ordered tree, with nothing in it.
+//----------------------------------------------------------------------
+
+OrderedTree::OrderedTree()
+{
+    root = NULL;
+    numItems = 0;
+    seed = 1;
+}
+
+//----------------------------------------------------------------------
+// OrderedTree::~OrderedTree
+// 	De-allocate the nodes of the tree; the items are not de-allocated.
+//----------------------------------------------------------------------
+
+OrderedTree::~OrderedTree()
+{
+    DeleteAll(root);
+}
+
+void
+OrderedTree::DeleteAll(TreeNode *tree)
+{
+    if (tree != NULL) {
+	DeleteAll(tree->left);
+	DeleteAll(tree->right);
+	delete tree;
+    }
+}
+
+//----------------------------------------------------------------------
+// OrderedTree::Insert
+// 	Put an item in the tree, after any items with the same key.
+//
+//	"item" is the thing to put in the tree
+//	"sortKey" is what the tree is ordered by
+//----------------------------------------------------------------------
+
+void
+OrderedTree::Insert(void *item, int sortKey)
+{
+    seed = seed * 1103515245 + 12345;	// the usual linear congruential
+					// generator; use its high bits
+    root = Insert(root, new TreeNode(item, sortKey, seed >> 8));
+    numItems++;
+}
+
+//----------------------------------------------------------------------
+// OrderedTree::Insert
+// 	Insert "node" into the subtree "tree", and return the new root
+//	of the subtree.
+//----------------------------------------------------------------------
+
+TreeNode *
+OrderedTree::Insert(TreeNode *tree, TreeNode *node)
+{
+    TreeNode *child;
+
+    if (tree == NULL)
+	return node;
+    if (node->key < tree->key) {
+	tree->left = Insert(tree->left, node);
+	if (tree->left->weight < tree->weight) {	// rotate right
+	    child = tree->left;
+	    tree->left = child->right;
+	    child->right = tree;
+	    return child;
+	}
+    } else {
+	tree->right = Insert(tree->right, node);
+	if (tree->right->weight < tree->weight) {	// rotate left
+	    child = tree->right;
+	    tree->right = child->left;
+	    child->left = tree;
+	    return child;
+	}
+    }
+    return tree;
+}
+
+//----------------------------------------------------------------------
+// OrderedTree::MinKey
+// 	Return the smallest key in the tree, which must not be empty.
+//----------------------------------------------------------------------
+
+int
+OrderedTree::MinKey()
+{
+    TreeNode *node = root;
+
+    ASSERT(node != NULL);
+    while (node->left != NULL)
+	node = node->left;
+    return node->key;
+}
+
+//----------------------------------------------------------------------
+// OrderedTree::RemoveMin
+// 	Remove the item with the smallest key (the first to be inserted,
+//	if there are several) from the tree, and return it.
+//
+// Returns:
+//	Pointer to the removed item, NULL if nothing is in the tree.
+//
+//	"keyPtr" is set to the key of the removed item (if not NULL)
+//----------------------------------------------------------------------
+
+void *
+OrderedTree::RemoveMin(int *keyPtr)
+{
+    TreeNode **link = &root;
+    TreeNode *node;
+    void *item;
+
+    if (root == NULL)
+	return NULL;
+    while ((*link)->left != NULL)
+	link = &(*link)->left;
+    node = *link;
+    *link = node->right;
+    item = node->item;
+    if (keyPtr != NULL)
+	*keyPtr = node->key;
+    delete node;
+    numItems--;
+    return item;
+}
+
+//----------------------------------------------------------------------
+// OrderedTree::Mapcar
+// 	Apply a function to each item in the tree, in order of their keys.
+//
+//	"func" is the procedure to apply to each item
+//----------------------------------------------------------------------
+
+void
+OrderedTree::Mapcar(VoidFunctionPtr func)
+{
+    Mapcar(root, func);
+}
+
+void
+OrderedTree::Mapcar(TreeNode *tree, VoidFunctionPtr func)
+{
+    if (tree != NULL) {
+	Mapcar(tree->left, func);
+	(*func)((int) tree->item);
+	Mapcar(tree->right, func);
+    }
+}
@@ -0,0 +1,69 @@
+// ordtree.h
+//	Data structures for an ordered tree: a set of items, each with an
+//	integer key, from which the item with the smallest key can be
+//	found and removed quickly.  Used as the run queue of the
+//	completely fair scheduler, keyed by virtual runtime.
+//
+//	The tree is a treap -- a binary search tree by key, which is also
+//	a heap by a pseudo-random "weight" given to each node when it is
+//	inserted.  That keeps it balanced (expected depth O(log n)) with
+//	much less code than a red-black tree.  Items with equal keys come
+//	out in the order they went in.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ORDTREE_H
+#define ORDTREE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// One item in the tree.
+
+class TreeNode {
+  public:
+    TreeNode(void *itemPtr, int sortKey, unsigned int nodeWeight);
+
+    void *operator new(size_t size);	// allocated from a free list
+    void operator delete(void *node);	// (see freelist.h)
+
+    void *item;			// the item in the tree
+    int key;			// what the tree is ordered by
+    unsigned int weight;	// no greater than the weights of its parent
+    TreeNode *left;		// items with smaller keys
+    TreeNode *right;		// items with larger (or equal) keys
+};
+
+// The following class defines an ordered tree.
+
+class OrderedTree {
+  public:
+    OrderedTree();			// initialize an empty tree
+    ~OrderedTree();			// de-allocate the tree (but not
+					// the items in it)
+
+    void Insert(void *item, int sortKey); // put an item in the tree
+    void *RemoveMin(int *keyPtr);	// remove the item with the smallest
+					// key, and return it (and its key);
+					// NULL if the tree is empty
+    int MinKey();			// the smallest key in the tree;
+					// the tree must not be empty
+    bool IsEmpty() { return (root == NULL); }
+    int NumItems() { return numItems; }
+
+    void Mapcar(VoidFunctionPtr func);	// apply "func" to every item,
+					// in order of their keys
+
+  private:
+    TreeNode *root;
+    int numItems;
+    unsigned int seed;			// for the node weights
+
+    TreeNode *Insert(TreeNode *tree, TreeNode *node);
+    void Mapcar(TreeNode *tree, VoidFunctionPtr func);
+    void DeleteAll(TreeNode *tree);
+};
+
+#endif // ORDTREE_H
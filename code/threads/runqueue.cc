@@ -0,0 +1,201 @@
+// runqueue.cc
+//	Routines to manage a priority run queue: one FIFO queue of
+//	threads per priority, and a bitmap of the non-empty queues.
+//
+//	Every operation takes constant time: Append and Remove just
+//	update one queue and a bit or two, and finding the highest
+//	priority queue in use is two find-first-set operations, one
+//	on "summary" to find the first non-zero word of "bitmap", and
+//	one on that word.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "runqueue.h"
+
+//----------------------------------------------------------------------
+// FirstSet
+// 	Return the index of the lowest bit set in "word", which must
+//	not be zero.
+//----------------------------------------------------------------------
+
+static int
+FirstSet(unsigned int word)
+{
+#ifdef __GNUC__
+    return __builtin_ctz(word);		// a single instruction on most hosts
+#else
+    int bit = 0;
+
+    while (!(word & 1)) {
+	word >>= 1;
+	bit++;
+    }
+    return bit;
+#endif
+}
+
+//----------------------------------------------------------------------
+// RunQueue::RunQueue
+// 	Initialize a run queue with no threads on it.
+//----------------------------------------------------------------------
+
+RunQueue::RunQueue()
+{
+    int i;
+
+    for (i = 0; i < NumPriorities; i++)
+	head[i] = tail[i] = NULL;
+    for (i = 0; i < PriorityWords; i++)
+	bitmap[i] = 0;
+    summary = 0;
+    numThreads = 0;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::~RunQueue
+// 	Nothing to de-allocate; the threads on the queue (if any) belong
+//	to someone else.
+//----------------------------------------------------------------------
+
+RunQueue::~RunQueue()
+{
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Append
+// 	Put a thread at the end of the queue for a priority, and
+//	mark that queue as in use.
+//
+//	"thread" is the thread to put on the queue
+//	"p" is the priority to queue it at
+//----------------------------------------------------------------------
+
+void
+RunQueue::Append(Thread *thread, int p)
+{
+    ASSERT((p >= HIGEST_PRIORITY) && (p <= LOWEST_PRIORITY));
+    ASSERT(thread->readyQueue == NULL);
+    thread->nextReady = NULL;
+    thread->prevReady = tail[p];
+    thread->readyQueue = this;
+    thread->readyLevel = p;
+    if (head[p] == NULL) {
+	head[p] = thread;
+	bitmap[p / BitsInWord] |= 1 << (p % BitsInWord);
+	summary |= 1 << (p / BitsInWord);
+    } else
+	tail[p]->nextReady = thread;
+    tail[p] = thread;
+    numThreads++;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Unlink
+// 	Take a thread off the queue it is on, wherever it is in the
+//	queue, and mark the queue as empty if it was the last one.
+//
+//	"thread" is the thread to take off; it must be on this run queue
+//----------------------------------------------------------------------
+
+void
+RunQueue::Unlink(Thread *thread)
+{
+    int p = thread->readyLevel;
+
+    ASSERT(thread->readyQueue == this);
+    if (thread->prevReady == NULL)
+	head[p] = thread->nextReady;
+    else
+	thread->prevReady->nextReady = thread->nextReady;
+    if (thread->nextReady == NULL)
+	tail[p] = thread->prevReady;
+    else
+	thread->nextReady->prevReady = thread->prevReady;
+    if (head[p] == NULL) {		// that was the last one
+	bitmap[p / BitsInWord] &= ~(1 << (p % BitsInWord));
+	if (bitmap[p / BitsInWord] == 0)
+	    summary &= ~(1 << (p / BitsInWord));
+    }
+    thread->nextReady = thread->prevReady = NULL;
+    thread->readyQueue = NULL;
+    numThreads--;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::BestPriority
+// 	Return the highest priority (smallest number) of any thread on
+//	the queue, or NumPriorities if there are none.
+//----------------------------------------------------------------------
+
+int
+RunQueue::BestPriority()
+{
+    int w;
+
+    if (summary == 0)
+	return NumPriorities;
+    w = FirstSet(summary);
+    return w * BitsInWord + FirstSet(bitmap[w]);
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Remove
+// 	Take the thread at the front of the highest priority queue in
+//	use off the queue, and return it; NULL if there are no threads.
+//----------------------------------------------------------------------
+
+Thread *
+RunQueue::Remove()
+{
+    Thread *thread;
+
+    if (summary == 0)
+	return NULL;
+    thread = head[BestPriority()];
+    Unlink(thread);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Requeue
+// 	Move a thread whose priority has changed to the end of the queue
+//	for its new priority, if it is on this run queue.
+//
+// Returns:
+//	TRUE if the thread was on this run queue.
+//
+//	"thread" is the thread to move
+//	"p" is the priority to queue it at now
+//----------------------------------------------------------------------
+
+bool
+RunQueue::Requeue(Thread *thread, int p)
+{
+    if (thread->readyQueue != this)
+	return FALSE;
+    Unlink(thread);
+    Append(thread, p);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Mapcar
+// 	Apply a function to each thread on the queue, highest priority
+//	first.  For debugging; takes time proportional to NumPriorities.
+//
+//	"func" is the procedure to apply to each thread
+//----------------------------------------------------------------------
+
+void
+RunQueue::Mapcar(VoidFunctionPtr func)
+{
+    Thread *thread;
+    int p;
+
+    for (p = 0; p < NumPriorities; p++)
+	for (thread = head[p]; thread != NULL; thread = thread->nextReady)
+	    (*func)((int) thread);
+}
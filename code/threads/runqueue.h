@@ -0,0 +1,68 @@
+// runqueue.h
+//	Data structures for a priority run queue with constant-time
+//	operations, used by the scheduler when threads have priorities.
+//
+//	There is one FIFO queue of threads per priority level, plus a
+//	bitmap recording which of the queues are non-empty, so that the
+//	highest priority ready thread can be found with a couple of
+//	find-first-set operations instead of a walk down a sorted list.
+//	The queues are linked (both ways) through the threads themselves,
+//	so putting a thread on a run queue never allocates memory, and a
+//	thread can be taken out of the middle of its queue, if its
+//	priority changes while it waits.
+//
+//	As elsewhere in Nachos, a smaller number is a higher priority:
+//	0 (HIGEST_PRIORITY) runs first, LOWEST_PRIORITY runs last.  The
+//	caller says which queue a thread goes on, so a scheduling policy
+//	can order threads by something other than their own priority.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RUNQUEUE_H
+#define RUNQUEUE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "thread.h"
+
+#define NumPriorities	(LOWEST_PRIORITY + 1)
+#define BitsInWord	32
+#define PriorityWords	((NumPriorities + BitsInWord - 1) / BitsInWord)
+
+// The following class defines a priority run queue: NumPriorities
+// FIFO queues of threads, and a two-level bitmap of which are in use.
+
+class RunQueue {
+  public:
+    RunQueue();				// initialize an empty run queue
+    ~RunQueue();
+
+    void Append(Thread *thread, int priority); // put "thread" at the
+					// end of the queue for "priority"
+    Thread *Remove();			// take the first thread off the
+					// highest priority queue; NULL if none
+    bool Requeue(Thread *thread, int priority); // move "thread" to the
+					// end of the queue for "priority";
+					// FALSE if it isn't on this run queue
+    bool IsEmpty() { return (summary == 0); }
+    int NumThreads() { return numThreads; }
+    int BestPriority();			// the priority Remove would pick;
+					// NumPriorities if empty
+
+    void Mapcar(VoidFunctionPtr func);	// apply "func" to every thread
+					// on the queue, in the order they
+					// would be removed
+
+  private:
+    void Unlink(Thread *thread);	// take "thread" off its queue
+
+    Thread *head[NumPriorities];	// first thread at each priority
+    Thread *tail[NumPriorities];	// and last, for Append
+    unsigned int bitmap[PriorityWords];	// bit p set if head[p] != NULL
+    unsigned int summary;		// bit w set if bitmap[w] != 0
+    int numThreads;			// threads on the queue
+};
+
+#endif // RUNQUEUE_H
@@ -11,8 +11,9 @@
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+//	Which ready thread runs next is decided by a scheduling policy
+//	(see scheduleralogrithms.h), chosen on the command line; the
+//	default is straight FIFO.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -22,19 +23,39 @@
 #include "scheduler.h"
 #include "system.h"
 #include "timer.h"
+#include "tid.h"
+
+//----------------------------------------------------------------------
+// SchedulerTick
+// 	Timer interrupt handler for preemptive scheduling policies: let
+//	the policy count down the running thread's time slice.
+//----------------------------------------------------------------------
+
+static void
+SchedulerTick(int dummy)
+{
+    if (interrupt->getStatus() != IdleMode)
+	scheduler->GetPolicy()->Tick(currentThread);
+}
 
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads to empty.
+//
+//	"schedPolicy" is the scheduling policy to use
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler()
+Scheduler::Scheduler(SchedPolicy *schedPolicy)
 { 
-    readyList = new List; 
-    allThreadList = new List;
-#ifdef SCHED_PRIORITY
-    timerInter = new Timer(Scheduler_RR, TIME_DELAY, false);
-#endif
+    policy = schedPolicy;
+    threadTable = new ThreadTable(TID_MAX_DEFAULT);
+    timerInter = NULL;
+    lastCharged = 0;
+    lastSystem = lastUser = 0;
+    preempting = FALSE;
+    numSwitches = 0;
+    if (policy->IsPreemptive())
+	timerInter = new Timer(SchedulerTick, 0, false);
 } 
 
 //----------------------------------------------------------------------
@@ -44,8 +65,9 @@ Scheduler::Scheduler()
 
 Scheduler::~Scheduler()
 { 
-    delete readyList; 
-    delete allThreadList;
+    delete policy; 
+    delete threadTable;
+    delete timerInter;
 } 
 
 //----------------------------------------------------------------------
@@ -53,6 +75,15 @@ Scheduler::~Scheduler()
 // 	Mark a thread as ready, but not running.
 //	Put it on the ready list, for later scheduling onto the CPU.
 //
+//	If the policy says the thread should preempt the one running,
+//	switch to it as soon as the caller re-enables interrupts -- or,
+//	inside an interrupt handler, as soon as the handler returns.
+//	Never right here: the caller has usually not finished changing
+//	whatever it woke the thread for (Semaphore::V, say, has still to
+//	count the V), and the woken thread must not see it half done.
+//	Not at all if the running thread is already on its way to sleep
+//	(see Condition::Wait); the switch to sleep will do.
+//
 //	"thread" is the thread to be put on the ready list.
 //----------------------------------------------------------------------
 
@@ -61,19 +92,29 @@ Scheduler::ReadyToRun (Thread *thread)
 {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
+    if (thread == currentThread)	// it's being preempted; bring its
+	ChargeRunningThread();		// vruntime up to date first
+    thread->getStats()->Readied(thread->getStatus() == BLOCKED);
     thread->setStatus(READY);
-#ifdef SCHED_PRIORITY//using priority-based interruptible scheduler
-    readyList->SortedInsert(thread, thread->getPriority());
-    if(currentThread->getPriority() > thread->getPriority()) {
-    	currentThread->Yield();
-    	}
-#elif SCHED_FIFO//FCFS
-    readyList->Append((void *)thread);
-#else //no scheduler defined
-    readyList->Append((void *)thread);
-#endif
+    policy->Enqueue(thread);
+    if (thread != currentThread && currentThread->getStatus() == RUNNING
+	    && policy->ShouldPreempt(currentThread, thread))
+	interrupt->YieldOnReturn();
+}
 
+//----------------------------------------------------------------------
+// Scheduler::Preempt
+// 	Take the CPU away from the current thread, if any other thread
+//	is ready: like Thread::Yield, except that the switch is counted
+//	as involuntary in the thread's statistics.
+//----------------------------------------------------------------------
 
+void
+Scheduler::Preempt()
+{
+    preempting = TRUE;
+    currentThread->Yield();
+    preempting = FALSE;			// in case there was no one to run
 }
 
 //----------------------------------------------------------------------
@@ -87,16 +128,7 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
-#ifdef SCHED_PRIORITY//using priority-based interruptible scheduler
-		int priorityOfJustRun = 255;//it is of no use...
-		return (Thread *)readyList->SortedRemove(&priorityOfJustRun);
-#elif SCHED_FIFO//FCFS
-		return (Thread *)readyList->Remove();
-#else //no scheduler defined
-		return (Thread *)readyList->Remove();
-#endif
-    return (Thread *)readyList->Remove();
-
+    return policy->PickNext();
 }
 
 //----------------------------------------------------------------------
@@ -128,6 +160,14 @@ Scheduler::Run (Thread *nextThread)
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
 
+    ChargeRunningThread();		    // the old thread is done, for now
+    oldThread->getStats()->Switched(preempting);
+    preempting = FALSE;
+    interrupt->CancelYield();		    // any switch asked for is this one
+    nextThread->getStats()->Dispatched();
+    nextThread->countSwitch();
+    numSwitches++;
+
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
     //currentThread->setTimeSlice(1);//every thread has one slice to be used
@@ -148,14 +188,9 @@ Scheduler::Run (Thread *nextThread)
     // before now (for example, in Thread::Finish()), because up to this
     // point, we were still running on the old thread's stack!
     if (threadToBeDestroyed != NULL) {
-    		if(scheduler->RemoveFromThreadList(threadToBeDestroyed)) {
-//    			printf("Removed successfully!\n");
-    		} else {
-//    			printf("Nothing to remove!\n");
-    			}
         delete threadToBeDestroyed;
         threadToBeDestroyed = NULL;
-    	}
+    }
     
 #ifdef USER_PROGRAM
     if (currentThread->space != NULL) {		// if there is an address space
@@ -167,32 +202,45 @@ Scheduler::Run (Thread *nextThread)
 
 //----------------------------------------------------------------------
 // Scheduler::Print
-// 	Print the scheduler state -- in other words, the contents of
-//	the ready list.  For debugging.
+// 	Print the scheduler state -- in other words, every thread, in
+//	order of tid, with what it has done with its time so far (see
+//	threadstats.h).  For debugging.
 //----------------------------------------------------------------------
 void
 Scheduler::Print()
 {
     //printf("Ready list contents:\n");
-    //readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
-	allThreadList->Mapcar((VoidFunctionPtr) ThreadPrint);
+    //policy->Print();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+	ChargeRunningThread();		// so its times are up to date
+	ThreadStats::PrintHeader();
+	threadTable->Mapcar((VoidFunctionPtr) ThreadPrint);
+	printf("Scheduling policy %s, %d context switches\n", policy->Name(),
+		numSwitches);
+	(void) interrupt->SetLevel(oldLevel);
 }
 
-/**
- * Add thread to allThreadList
- */
-void Scheduler::AddToAllThreadList(Thread* thread) {
-	allThreadList->Append((void *)thread);
-}
-/**
- * Remove current thread from AllThreadList
- */
-bool Scheduler::RemoveFromThreadList(Thread *threadToBeRemoved) {
-	return allThreadList->RemoveItem(threadToBeRemoved);
-}
-/**
- * Multiply all thread priority by percent.
- */
-void Scheduler::AdjustAllPriority() {
-	allThreadList->Mapcar((VoidFunctionPtr)DecreasePriority);
+//----------------------------------------------------------------------
+// Scheduler::ChargeRunningThread
+// 	Add the CPU time used by the current thread, since it was last
+//	charged, to its virtual runtime.  Time spent idle (in
+//	Interrupt::Idle, waiting for an interrupt with no thread to run)
+//	isn't charged to anyone.
+//
+//	Also charge it, in its statistics, for the time it has spent
+//	running kernel and user code.
+//----------------------------------------------------------------------
+void
+Scheduler::ChargeRunningThread()
+{
+    int busy = stats->totalTicks - stats->idleTicks;
+
+    currentThread->ChargeTime(busy - lastCharged);
+    lastCharged = busy;
+    currentThread->getStats()->Ran(stats->systemTicks - lastSystem,
+	stats->userTicks - lastUser);
+    lastSystem = stats->systemTicks;
+    lastUser = stats->userTicks;
 }
+
@@ -14,36 +14,46 @@
 #include "thread.h"
 #include "timer.h"
 #include "scheduleralogrithms.h"
-#define TIME_DELAY 0
-//#define SCHED_PRIORITY
-//#define SCHED_FIFO
+#include "threadtable.h"
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
+// Which ready thread runs next is up to the scheduling policy.
 
 class Scheduler {
   public:
-    Scheduler();			// Initialize list of ready threads 
+    Scheduler(SchedPolicy *schedPolicy); // Initialize list of ready threads
     ~Scheduler();			// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
     Thread* FindNextToRun();		// Dequeue first thread on the ready 
 					// list, if any, and return thread.
     void Run(Thread* nextThread);	// Cause nextThread to start running
-    void Print();			// Print contents of ready list
+    void Print();			// Print every thread
 
-    List *GetAllThreadList() {	return allThreadList; }
-    List *GetReadyList() { return readyList; }
-    void AddToAllThreadList(Thread* thread); //add thread to all thread list
-    bool RemoveFromThreadList(Thread* threadToBeRemoved);//Remove specified item from list, if no item matched, return false.
-    void AdjustAllPriority();
+    ThreadTable *GetThreadTable() { return threadTable; }
+    SchedPolicy *GetPolicy() { return policy; }
+    int NumSwitches() { return numSwitches; }	// context switches so far
+    void Preempt();			// take the CPU away from the
+					// current thread
+    void ChargeRunningThread();		// add the CPU time used since the
+					// last call to currentThread's vruntime
+					// and statistics
     
   private:
-    List *readyList;  		// queue of threads that are ready to run,
-				// but not running
-    List *allThreadList;
-    Timer *timerInter;
+    SchedPolicy *policy;	// keeps the threads that are ready to run,
+				// but not running, and picks among them
+    ThreadTable *threadTable;	// every thread, by tid
+    Timer *timerInter;		// drives policy->Tick, if the policy
+				// is preemptive
+    int lastCharged;		// non-idle ticks, when the running thread
+				// was last charged for its CPU time
+    int lastSystem;		// and system and user ticks
+    int lastUser;
+    bool preempting;		// TRUE while Preempt is switching away
+				// from the current thread
+    int numSwitches;		// context switches so far
 };
 
 #endif // SCHEDULER_H
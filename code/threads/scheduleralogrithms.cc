@@ -3,48 +3,217 @@
  *
  *  Created on: 2012-10-19
  *      Author: rye
+ *
+ * The scheduling policies (see scheduleralogrithms.h).  Tick is called
+ * from the scheduler's timer interrupt handler; a thread's time slice
+ * is counted down in its "timeSlices", one per timer interrupt.
  */
 #include "scheduleralogrithms.h"
-#include "list.h"
 #include "system.h"
-int d = 2;
-void Scheduler_RR(int delay) {
-	if(interrupt->getStatus() == IdleMode) {
-		// Do nothing
+
+//----------------------------------------------------------------------
+// NewSchedPolicy
+// 	Return a new scheduling policy, given its name on the command line.
+//----------------------------------------------------------------------
+
+SchedPolicy *
+NewSchedPolicy(char *name)
+{
+	if (!strcmp(name, "fifo"))
+		return new FifoPolicy;
+	if (!strcmp(name, "rr"))
+		return new RoundRobinPolicy;
+	if (!strcmp(name, "priority"))
+		return new PriorityPolicy;
+	if (!strcmp(name, "mlfq"))
+		return new MlfqPolicy;
+	if (!strcmp(name, "cfs"))
+		return new CfsPolicy;
+	return NULL;
+}
+
+//----------------------------------------------------------------------
+// FifoPolicy
+//----------------------------------------------------------------------
+
+void FifoPolicy::Enqueue(Thread *thread) {
+	readyList->Append(thread, 0);
+}
+
+//----------------------------------------------------------------------
+// RoundRobinPolicy
+//	A thread gets a new slice each time it is put on the ready list.
+//----------------------------------------------------------------------
+
+void RoundRobinPolicy::Enqueue(Thread *thread) {
+	thread->setDefaultTimeSlice();
+	readyList->Append(thread, 0);
+}
+
+void RoundRobinPolicy::Tick(Thread *running) {
+	int slicesLeft = running->getTimeSlice();
+
+	if(slicesLeft > 0) {
+		running->setTimeSlice(slicesLeft - 1);
 		return;
 	}
-//	printf("%s:tid is %d, priority is %d,slice left is %d\n", currentThread->getName(),currentThread->getTid(),currentThread->getPriority(),currentThread->getTimeSlice());
-	//if(d--) return;
-	//else d = 2;
-	int slicesLeft = currentThread->getTimeSlice();
-	int priority = currentThread->getPriority();
-	List *readyList = scheduler->GetReadyList();
-
-	if(slicesLeft--) {
-//		printf("Has slices left\n");
-		currentThread->setTimeSlice(slicesLeft);
+	running->setDefaultTimeSlice();
+	if(!readyList->IsEmpty())
+		interrupt->YieldOnReturn();
+}
+
+//----------------------------------------------------------------------
+// PriorityPolicy
+//	Two sets of O(1) run queues, as in the Linux 2.6 scheduler: when
+//	no active thread is left, the two are swapped, which gives every
+//	expired thread a new slice at once, with no need to walk the
+//	threads and age their priorities.
+//----------------------------------------------------------------------
+
+void PriorityPolicy::Enqueue(Thread *thread) {
+	if (thread->sliceExpired()) {	// wait for the others to have a turn
+		thread->setDefaultTimeSlice();
+		expired->Append(thread, thread->getPriority());
+	} else
+		active->Append(thread, thread->getPriority());
+}
+
+Thread *PriorityPolicy::PickNext() {
+	if (active->IsEmpty()) {	// everyone has had their slice;
+		RunQueue *tmp = active;	// start a new round
+		active = expired;
+		expired = tmp;
+	}
+	return active->Remove();
+}
+
+void PriorityPolicy::Tick(Thread *running) {
+	int slicesLeft = running->getTimeSlice();
+
+	if(slicesLeft > 0) {
+		running->setTimeSlice(slicesLeft - 1);
 		return;
 	}
-	if(slicesLeft <= 0) {
-//		printf("No more slices left yield\n");
-		currentThread->setDefaultTimeSlice();
+	// No more slices left: Enqueue puts the thread on the expired run
+	// queue, behind every thread that still has a slice to use.
+	running->setTimeSlice(TIMESLICE_EXPIRED);
+	if(!active->IsEmpty() || !expired->IsEmpty())
 		interrupt->YieldOnReturn();
+}
 
-	}
+bool PriorityPolicy::ShouldPreempt(Thread *running, Thread *woken) {
+	return (woken->getPriority() < running->getPriority());
+}
+
+void PriorityPolicy::PriorityChanged(Thread *thread) {
+	if (!active->Requeue(thread, thread->getPriority()))
+		expired->Requeue(thread, thread->getPriority());
+}
+
+void PriorityPolicy::Print() {
+	active->Mapcar((VoidFunctionPtr) ThreadPrint);
+	expired->Mapcar((VoidFunctionPtr) ThreadPrint);
+}
 
-	currentThread->setPriority(++priority);
-	if(priority >= 255) {
-//		printf("Priority is out of range\n");
-		scheduler->AdjustAllPriority();
+//----------------------------------------------------------------------
+// MlfqPolicy
+//	A thread's level is kept in its "schedLevel".  Its slice is only
+//	renewed once used up, so a thread that keeps blocking just before
+//	the end of its slice is still demoted eventually.
+//----------------------------------------------------------------------
+
+void MlfqPolicy::Enqueue(Thread *thread) {
+	int level = thread->getSchedLevel();
+
+	if (thread->sliceExpired()) {	// used a whole slice; move down
+		if (level < MlfqLevels - 1)
+			thread->setSchedLevel(++level);
+		thread->setTimeSlice(MlfqQuantum(level));
 	}
-	if(!readyList->IsEmpty() && priority < ((Thread *)readyList->Front()->item)->getPriority()) {
-		//Do nothing
-//		printf("Current thread has the highest priority\n");
+	queue->Append(thread, level);
+}
+
+void MlfqPolicy::Tick(Thread *running) {
+	int slicesLeft = running->getTimeSlice();
+
+	if(++ticksSinceBoost >= MlfqBoostTicks)
+		Boost();
+	if(slicesLeft > 0) {
+		running->setTimeSlice(slicesLeft - 1);
 		return;
-	} else {
-//		printf("There is a thread with higher priority\n");
+	}
+	running->setTimeSlice(TIMESLICE_EXPIRED);
+	if(!queue->IsEmpty())
 		interrupt->YieldOnReturn();
+}
+
+bool MlfqPolicy::ShouldPreempt(Thread *running, Thread *woken) {
+	return (woken->getSchedLevel() < running->getSchedLevel());
+}
+
+static void ResetLevel(int arg) {
+	Thread *t = (Thread *)arg;
+	t->setSchedLevel(0);
+}
+
+void MlfqPolicy::Boost() {
+	int n = queue->NumThreads();
+
+	DEBUG('t', "MLFQ: moving all threads to the top queue\n");
+	ticksSinceBoost = 0;
+	while (n-- > 0)			// requeue each ready thread once,
+		queue->Append(queue->Remove(), 0);	// keeping their order
+	scheduler->GetThreadTable()->Mapcar(ResetLevel);
+}
+
+//----------------------------------------------------------------------
+// CfsPolicy
+//	The running thread's vruntime is brought up to date (by the
+//	scheduler) before it is compared with anyone else's.  A thread
+//	that has been asleep is not allowed to start more than
+//	CfsSleeperCredit behind the others, or it would hog the CPU
+//	until it caught up.
+//----------------------------------------------------------------------
+
+void CfsPolicy::Enqueue(Thread *thread) {
+	if (thread->getVruntime() < minVruntime - CfsSleeperCredit)
+		thread->setVruntime(minVruntime - CfsSleeperCredit);
+	tree->Insert(thread, thread->getVruntime());
+}
+
+Thread *CfsPolicy::PickNext() {
+	Thread *thread = (Thread *)tree->RemoveMin(NULL);
+
+	if (thread != NULL) {
+		if (thread->getVruntime() > minVruntime)
+			minVruntime = thread->getVruntime();
+		thread->setTimeSlice(Slice() - 1);
 	}
+	return thread;
+}
+
+int CfsPolicy::Slice() {
+	int slice = CfsTargetLatency / (tree->NumItems() + 1);
+
+	return (slice < CfsMinGranularity) ? CfsMinGranularity : slice;
 }
 
+void CfsPolicy::Tick(Thread *running) {
+	int slicesLeft = running->getTimeSlice();
 
+	if(slicesLeft > 0) {
+		running->setTimeSlice(slicesLeft - 1);
+		return;
+	}
+	scheduler->ChargeRunningThread();
+	if(!tree->IsEmpty() && tree->MinKey() < running->getVruntime())
+		interrupt->YieldOnReturn();
+	else				// still the furthest behind
+		running->setTimeSlice(Slice() - 1);
+}
+
+bool CfsPolicy::ShouldPreempt(Thread *running, Thread *woken) {
+	scheduler->ChargeRunningThread();
+	return (woken->getVruntime() + CfsWakeupGranularity
+		< running->getVruntime());
+}
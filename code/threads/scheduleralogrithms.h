@@ -3,14 +3,172 @@
  *
  *  Created on: 2012-10-19
  *      Author: rye
+ *
+ * Scheduling policies.  The Scheduler keeps track of which thread is
+ * running and does the context switches; a policy decides which ready
+ * thread runs next, and when the running thread should give up the CPU.
+ * The policy is chosen when Nachos starts, with "-sched <name>".
  */
 
 #ifndef SHCEDULERALOGRITHMS_H_
 #define SHCEDULERALOGRITHMS_H_
+#include "list.h"
+#include "thread.h"
+#include "runqueue.h"
+#include "ordtree.h"
+#include "stats.h"
 #ifndef LOWEST_PRIORITY
 #define LOWEST_PRIORITY 255
 #endif
 
-extern void Scheduler_RR(int delay);
-extern int d;
+#define MlfqLevels	8		// number of MLFQ queues
+#define MlfqQuantum(level) (1 << (level)) // time slices a thread gets at
+					// each level before being demoted
+#define MlfqBoostTicks	64		// timer interrupts between moving every
+					// thread back up to the top queue
+
+#define CfsTargetLatency 8		// timer interrupts in which every
+					// runnable thread should get to run
+#define CfsMinGranularity 1		// but no slice is shorter than this
+#define CfsWakeupGranularity (TimerTicks / 2) // how far behind in vruntime
+					// a woken thread must be to preempt
+#define CfsSleeperCredit (CfsTargetLatency * TimerTicks / 2) // how far
+					// behind the others a thread that
+					// slept for a long time may start
+
+// The interface to a scheduling policy.  All the routines are called
+// with interrupts disabled.
+
+class SchedPolicy {
+  public:
+    virtual ~SchedPolicy() {}
+
+    virtual char *Name() = 0;
+    virtual void Enqueue(Thread *thread) = 0;	// "thread" is ready to run
+    virtual Thread *PickNext() = 0;		// remove and return the next
+						// thread to run; NULL if none
+    virtual bool IsPreemptive() { return FALSE; }
+						// does it need Tick?
+    virtual void Tick(Thread *running) {}	// a timer interrupt happened
+						// while "running" had the CPU;
+						// may ask it to YieldOnReturn
+    virtual bool ShouldPreempt(Thread *running, Thread *woken)
+	{ return FALSE; }			// yield hint: should "woken",
+						// just made ready, take the CPU
+						// from "running" right away?
+    virtual void PriorityChanged(Thread *thread) {} // "thread", which is
+						// ready, has a new priority
+    virtual void Print() {}			// print the ready threads
+};
+
+// First come, first served: threads run until they block or yield.
+// This is the default, and what Nachos has always done.
+
+class FifoPolicy : public SchedPolicy {
+  public:
+    FifoPolicy() { readyList = new RunQueue; }
+    ~FifoPolicy() { delete readyList; }
+
+    char *Name() { return "fifo"; }
+    void Enqueue(Thread *thread);
+    Thread *PickNext() { return readyList->Remove(); }
+    void Print() { readyList->Mapcar((VoidFunctionPtr) ThreadPrint); }
+
+  protected:
+    RunQueue *readyList;	// all at one level, so it's a FIFO
+};
+
+// Round robin: FIFO, but a thread that uses up its time slice goes to
+// the back of the ready list.
+
+class RoundRobinPolicy : public FifoPolicy {
+  public:
+    char *Name() { return "rr"; }
+    void Enqueue(Thread *thread);
+    bool IsPreemptive() { return TRUE; }
+    void Tick(Thread *running);
+};
+
+// Static priority: the highest priority ready thread runs, and preempts
+// a lower priority one as soon as it is ready.  Threads of the same
+// priority take turns: one that uses up its slice waits on the expired
+// run queue until the rest of the active ones have had theirs.
+
+class PriorityPolicy : public SchedPolicy {
+  public:
+    PriorityPolicy() { active = new RunQueue; expired = new RunQueue; }
+    ~PriorityPolicy() { delete active; delete expired; }
+
+    char *Name() { return "priority"; }
+    void Enqueue(Thread *thread);
+    Thread *PickNext();
+    bool IsPreemptive() { return TRUE; }
+    void Tick(Thread *running);
+    bool ShouldPreempt(Thread *running, Thread *woken);
+    void PriorityChanged(Thread *thread);
+    void Print();
+
+  private:
+    RunQueue *active;		// ready threads that still have time
+				// slices to use up
+    RunQueue *expired;		// and ready threads that have used theirs;
+				// they run once "active" is empty
+};
+
+// Multilevel feedback queue: threads start in the top queue, and move
+// down a queue each time they use up a whole time slice, which gets
+// longer further down; a thread that blocks or yields first stays where
+// it is.  Every MlfqBoostTicks, all threads go back to the top, so that
+// long-running threads can't be starved.
+
+class MlfqPolicy : public SchedPolicy {
+  public:
+    MlfqPolicy() { queue = new RunQueue; ticksSinceBoost = 0; }
+    ~MlfqPolicy() { delete queue; }
+
+    char *Name() { return "mlfq"; }
+    void Enqueue(Thread *thread);
+    Thread *PickNext() { return queue->Remove(); }
+    bool IsPreemptive() { return TRUE; }
+    void Tick(Thread *running);
+    bool ShouldPreempt(Thread *running, Thread *woken);
+    void Print() { queue->Mapcar((VoidFunctionPtr) ThreadPrint); }
+
+  private:
+    RunQueue *queue;		// indexed by level, 0 at the top
+    int ticksSinceBoost;	// timer interrupts since the last boost
+
+    void Boost();		// move every thread back to the top
+};
+
+// Completely fair: the thread that has had the least CPU time, weighted
+// by priority (its virtual runtime, see Thread::ChargeTime), runs
+// next.  The ready threads are kept in a tree ordered by vruntime.  Each
+// gets a slice of the target latency divided among the runnable threads;
+// when it is used up, the thread is preempted if another one is now
+// further behind.
+
+class CfsPolicy : public SchedPolicy {
+  public:
+    CfsPolicy() { tree = new OrderedTree; minVruntime = 0; }
+    ~CfsPolicy() { delete tree; }
+
+    char *Name() { return "cfs"; }
+    void Enqueue(Thread *thread);
+    Thread *PickNext();
+    bool IsPreemptive() { return TRUE; }
+    void Tick(Thread *running);
+    bool ShouldPreempt(Thread *running, Thread *woken);
+    void Print() { tree->Mapcar((VoidFunctionPtr) ThreadPrint); }
+
+  private:
+    OrderedTree *tree;		// ready threads, keyed by vruntime
+    int minVruntime;		// vruntime of the thread most recently
+				// picked; never decreases
+    int Slice();		// time slices for the thread to run next
+};
+
+// Return the policy called "name", or NULL if there is no such policy.
+extern SchedPolicy *NewSchedPolicy(char *name);
+
 #endif /* SHCEDULERALOGRITHMS_H_ */
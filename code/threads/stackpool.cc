@@ -0,0 +1,93 @@
+// stackpool.cc
+//	Routines to recycle thread execution stacks.
+//
+//	Stacks are reused last in, first out, since the most recently
+//	freed stack is the most likely to still be in the host's cache.
+//	The statistics count how many stacks had to be allocated, and
+//	how many came from the pool.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "stackpool.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// StackPool::StackPool
+// 	Initialize an empty pool of stacks.
+//
+//	"stackSize" is the size of each stack, in bytes
+//	"maxStacks" is how many unused stacks to keep, at most; 0 means
+//		always free a stack when its thread is done with it
+//----------------------------------------------------------------------
+
+StackPool::StackPool(int stackSize, int maxStacks)
+{
+    ASSERT(maxStacks >= 0);
+    size = stackSize;
+    maxFree = maxStacks;
+    numFree = 0;
+    pool = new int *[maxStacks + 1];
+}
+
+//----------------------------------------------------------------------
+// StackPool::~StackPool
+// 	Free the stacks in the pool.  Stacks still in use by threads
+//	belong to the threads.
+//----------------------------------------------------------------------
+
+StackPool::~StackPool()
+{
+    while (numFree > 0)
+	DeallocBoundedArray((char *) pool[--numFree], size);
+    delete [] pool;
+}
+
+//----------------------------------------------------------------------
+// StackPool::Alloc
+// 	Return a stack, with guard pages on either side: the one most
+//	recently freed, if any, otherwise a new one.
+//----------------------------------------------------------------------
+
+int *
+StackPool::Alloc()
+{
+    if (numFree > 0) {
+	stats->numStackReuses++;
+	return pool[--numFree];
+    }
+    stats->numStackAllocs++;
+    return (int *) AllocBoundedArray(size);
+}
+
+//----------------------------------------------------------------------
+// StackPool::Free
+// 	Give back a stack returned by Alloc.  It goes into the pool if
+//	there's room, otherwise it is de-allocated.
+//
+//	"stack" is the stack no longer in use
+//----------------------------------------------------------------------
+
+void
+StackPool::Free(int *stack)
+{
+    if (numFree < maxFree)
+	pool[numFree++] = stack;
+    else
+	DeallocBoundedArray((char *) stack, size);
+}
+
+//----------------------------------------------------------------------
+// StackPool::Guarded
+// 	Return TRUE if the stacks really have guard pages, so that an
+//	overflow is caught when it happens, not just noticed afterwards
+//	by Thread::CheckOverflow.
+//----------------------------------------------------------------------
+
+bool
+StackPool::Guarded()
+{
+    return BoundedArraysGuarded();
+}
@@ -0,0 +1,42 @@
+// stackpool.h
+//	Data structures for a pool of thread execution stacks.
+//
+//	Allocating a stack means mapping fresh memory and protecting the
+//	guard pages on either side of it (see AllocBoundedArray), which
+//	is slow compared to everything else Thread::Fork does.  So when
+//	a thread is destroyed, its stack is kept for the next Fork, guard
+//	pages and all -- up to a limit, beyond which stacks are freed.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef STACKPOOL_H
+#define STACKPOOL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define StackPoolSize	32	// default number of stacks kept for reuse
+
+// The following class defines a pool of stacks, each "size" bytes.
+
+class StackPool {
+  public:
+    StackPool(int stackSize, int maxStacks); // initialize an empty pool
+    ~StackPool();			// free the stacks in the pool
+
+    int *Alloc();			// a stack, from the pool if possible
+    void Free(int *stack);		// done with "stack"; keep it for
+					// reuse, unless the pool is full
+    bool Guarded();			// TRUE if running off the end of a
+					// stack causes a fault right away
+
+  private:
+    int size;				// bytes in each stack
+    int **pool;				// stacks ready for reuse
+    int numFree;			// how many there are
+    int maxFree;			// most there can be
+};
+
+#endif // STACKPOOL_H
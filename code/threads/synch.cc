@@ -37,7 +37,8 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 {
 	name = debugName;
 	value = initialValue;
-	queue = new List;
+	queue = new RunQueue;
+	PROFILE(profile = SynchProfile::Find("Semaphore", name));
 }
 
 //----------------------------------------------------------------------
@@ -67,11 +68,14 @@ Semaphore::P()
 	//printf("%s: P() value before inter is %d\n",name ,value);
 	//printf("currentThread is %s\n", currentThread->getName());
 	IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+	PROFILE(int waitStart = stats->totalTicks);
+	PROFILE(bool waited = (value == 0));
 	while (value == 0) { 			// semaphore not available
 
-		queue->Append((void *)currentThread);	// so go to sleep
-		currentThread->Sleep();
+		queue->Append(currentThread, 0);	// so go to sleep
+		currentThread->Sleep(BlockedSemaphore);
 	}
+	PROFILE(if (waited) profile->Waited(waitStart); else profile->Acquired());
 	//printf("%s value is %d\n", name, value);
 
 	//printf("value is %d\n", value);
@@ -99,93 +103,240 @@ Semaphore::V()
 	Thread *thread;
 	IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-	thread = (Thread *)queue->Remove();
-	if (thread != NULL)	   // make thread ready, consuming the V immediately
-		scheduler->ReadyToRun(thread);
 	value++;
+	thread = queue->Remove();
+	if (thread != NULL)	   // make thread ready, to consume the V
+		scheduler->ReadyToRun(thread);
 	(void) interrupt->SetLevel(oldLevel);
 }
 
-// Dummy functions -- so we can compile our later assignments 
-// Note -- without a correct implementation of Condition::Wait(), 
-// the test case in the network assignment won't work!
+//----------------------------------------------------------------------
+// Lock::Lock
+// 	Initialize a lock, so that it can be used for synchronization.
+//	The lock is initially FREE.
+//
+//	"lockname" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
 Lock::Lock(char *lockname) {
 	name = lockname;
-	threadID = -1;
-	locked = false;
-	queue = new List();
+	holder = NULL;
+	queue = new RunQueue;
+	nextHeld = NULL;
+	PROFILE(profile = SynchProfile::Find("Lock", name));
 }
 
+//----------------------------------------------------------------------
+// Lock::~Lock
+// 	De-allocate a lock.  Assume no one holds it, or is waiting for it.
+//----------------------------------------------------------------------
+
 Lock::~Lock() {
 	delete queue;
 }
+
+//----------------------------------------------------------------------
+// Lock::Acquire
+// 	Wait until the lock is FREE, then take it.  While waiting, lend
+//	our priority to the holder.  Release hands the lock straight to
+//	the thread it wakes up, so when Sleep returns, we have the lock
+//	-- no other thread can slip in and take it first, only for us
+//	to have to go back to sleep.  Release also counts the wait in the
+//	profile, since not every thread it hands the lock to is in
+//	Acquire (see AcquireFor).
+//----------------------------------------------------------------------
+
 void Lock::Acquire() {
 	IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
-	//	printf("a.1\n");
-	while (locked) { 			// if it is locked, sleep.
-		//		lockedThread = currentThread;
-		//		printf("a.2\n");
-		queue->Append((void *)currentThread);
-		currentThread->Sleep();
+	if (holder == NULL) {			// if it's not locked, acquire the lock.
+		GiveTo(currentThread);
+		PROFILE(profile->Acquired());
+	} else {				// if it is locked, sleep.
+		Enqueue(currentThread);
+		currentThread->Sleep(BlockedLock);
+		ASSERT(holder == currentThread);	// handed over by Release
 	}
-	//	printf("a.3\n");
-	threadID = currentThread->getTid();
-	locked = true; // if it's not locked, acquire the lock.
 	(void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
 }
+
+//----------------------------------------------------------------------
+// Lock::GiveTo
+// 	Make a thread the holder of the lock, which must be FREE.  The
+//	thread takes on the priority of anyone still waiting for it.
+//
+//	"thread" is the new holder
+//----------------------------------------------------------------------
+
+void Lock::GiveTo(Thread *thread) {
+	ASSERT(holder == NULL);
+	holder = thread;
+	PROFILE(heldSince = stats->totalTicks);
+	nextHeld = thread->heldLocks;
+	thread->heldLocks = this;
+	thread->UpdatePriority();
+}
+
+//----------------------------------------------------------------------
+// Lock::Enqueue
+// 	Put a blocked thread on the queue of threads waiting for the
+//	lock, and donate its priority to the holder.
+//
+//	"thread" is the thread to wait for the lock
+//----------------------------------------------------------------------
+
+void Lock::Enqueue(Thread *thread) {
+	thread->waitingFor = this;
+	PROFILE(thread->lockWaitStart = stats->totalTicks);
+	queue->Append(thread, thread->getPriority());
+	Donate(thread->getPriority());
+}
+
+//----------------------------------------------------------------------
+// Lock::AcquireFor
+// 	Make a thread that is asleep (waiting on a condition variable)
+//	acquire the lock, without waking it up first: it gets the lock
+//	and is made ready now if the lock is FREE, otherwise it waits on
+//	the lock's queue, as if it had called Acquire.
+//
+//	"thread" is the sleeping thread
+//----------------------------------------------------------------------
+
+void Lock::AcquireFor(Thread *thread) {
+	if (holder == NULL) {
+		GiveTo(thread);
+		PROFILE(profile->Acquired());
+		scheduler->ReadyToRun(thread);
+	} else
+		Enqueue(thread);
+}
+
+//----------------------------------------------------------------------
+// Lock::Donate
+// 	Raise the priority of the lock's holder to at least "pri".  If
+//	the holder is itself waiting for a lock, pass the donation on
+//	to that lock's holder, and so on down the chain.  Stops as soon
+//	as a thread already has that high a priority, so a deadlock
+//	(a cycle of threads waiting for each other) can't loop forever.
+//
+//	"pri" is the priority of the thread starting to wait
+//----------------------------------------------------------------------
+
+void Lock::Donate(int pri) {
+	Lock *lock = this;
+
+	while (lock != NULL && lock->holder != NULL &&
+			lock->holder->getPriority() > pri) {
+		DEBUG('t', "Lock %s: raising \"%s\" to priority %d\n",
+			lock->name, lock->holder->getName(), pri);
+		lock->holder->ChangePriority(pri);
+		lock = lock->holder->waitingFor;
+	}
+}
+
+//----------------------------------------------------------------------
+// Lock::Release
+// 	Hand the lock over to the highest priority thread waiting for
+//	it, and wake that thread up; if no one is waiting, set the lock
+//	FREE.  We drop back to the priority we would have without the
+//	donations made through this lock.
+//----------------------------------------------------------------------
+
 void Lock::Release() {
 	IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
 	if(isHeldByCurrentThread())	{//only the thread that acquired the lock may release it.
-		if(!queue->IsEmpty()) {
-			scheduler->ReadyToRun((Thread *)queue->Remove());
+		Lock **link = &holder->heldLocks;
+		Thread *thread;
+
+		while (*link != this)
+			link = &(*link)->nextHeld;
+		*link = nextHeld;
+		nextHeld = NULL;
+		holder = NULL; // release the lock
+		PROFILE(profile->Held(heldSince));
+		currentThread->UpdatePriority();
+
+		thread = queue->Remove();
+		if (thread != NULL) {
+			thread->waitingFor = NULL;
+			GiveTo(thread);
+			PROFILE(profile->Waited(thread->lockWaitStart, thread));
+			scheduler->ReadyToRun(thread);	// may switch to it, at SetLevel
 		}
-		locked = false; // release the lock
 	}
 	(void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
 }
+
 bool Lock::isHeldByCurrentThread() {
-	if(threadID == currentThread->getTid()) {
-		return true;
-	} else {
-		return false;
-	}
+	return (holder == currentThread);
 }
 
 Condition::Condition(char* debugName) {
 	name = debugName;
-	//	numSleepers = 0;
-	queue = new List();
+	queue = new RunQueue;
+	PROFILE(profile = SynchProfile::Find("Condition", name));
 }
 Condition::~Condition() {
 	delete queue;
 }
+
+//----------------------------------------------------------------------
+// Condition::Wait
+// 	Release the lock and sleep until signalled.  Signal moves us
+//	from the condition's queue to the lock's ("wait morphing"), so
+//	we only wake up once we have the lock back.  We're on the queue
+//	before the lock is released, and marked as blocked, so that
+//	handing the lock to a higher priority thread doesn't switch to
+//	it until we are asleep.
+//----------------------------------------------------------------------
+
 void Condition::Wait(Lock* conditionLock) {
 	IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
-	//	numSleepers++;
-	//	printf("cv wait 1\n");
+	PROFILE(int waitStart = stats->totalTicks);
+	queue->Append(currentThread, currentThread->getPriority());
+	currentThread->waitingCondition = this;
+	currentThread->setStatus(BLOCKED);
 	conditionLock->Release();
-	queue->Append((void *)currentThread);
-	//	printf("cv wait 2\n");
-	currentThread->Sleep();
+	currentThread->Sleep(BlockedCondition);	// including any wait for
+						// the lock, once signalled
+	ASSERT(conditionLock->isHeldByCurrentThread());
+	PROFILE(profile->Waited(waitStart));
 	(void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
-	//	printf("cv wait 3\n");
-	conditionLock->Acquire();
 }
+
+//----------------------------------------------------------------------
+// Condition::Signal
+// 	Move the highest priority waiter, if any, onto the lock's queue;
+//	it runs once the signaller (or whoever holds the lock then)
+//	releases the lock.  Waking it up right away would only have it
+//	block again on the lock, which is still held.
+//----------------------------------------------------------------------
+
 void Condition::Signal(Lock* conditionLock) {
 	IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
-	//	conditionLock->Release();
-	if(!queue->IsEmpty()) {
+	Thread *thread;
 
-		scheduler->ReadyToRun((Thread *)queue->Remove());
+	if(!queue->IsEmpty()) {
+		thread = queue->Remove();
+		thread->waitingCondition = NULL;
+		conditionLock->AcquireFor(thread);
 	}
 	(void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
 }
+
+//----------------------------------------------------------------------
+// Condition::Broadcast
+// 	Move every waiter onto the lock's queue, so they run one at a
+//	time, as the lock is handed from one to the next.
+//----------------------------------------------------------------------
+
 void Condition::Broadcast(Lock* conditionLock) {
 	IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
-	//	conditionLock->Release();
+	Thread *thread;
+
 	while(!queue->IsEmpty()) {
-		//		printf("Broad cast\n");
-		scheduler->ReadyToRun((Thread *)queue->Remove());
+		thread = queue->Remove();
+		thread->waitingCondition = NULL;
+		conditionLock->AcquireFor(thread);
 	}
 	(void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
 }
@@ -200,6 +351,7 @@ Barrier::Barrier(char* debugName, int size) {
 	cv = new Condition(name);
 	lock = new Lock(name);
 	finished = 0;
+	PROFILE(profile = SynchProfile::Find("Barrier", name));
 }
 Barrier::~Barrier() {
 	delete lock;
@@ -207,11 +359,14 @@ Barrier::~Barrier() {
 }
 
 void Barrier::Wait() {
+	PROFILE(int waitStart = stats->totalTicks);
 	lock->Acquire();
 	if(finished != barrierSize-1) {
 		finished++;
 		cv->Wait(lock);
+		PROFILE(profile->Waited(waitStart));
 	} else {
+		PROFILE(profile->Acquired());
 		//		printf("d\n");
 		finished = 0;
 		cv->Broadcast(lock);
@@ -228,3 +383,225 @@ void Barrier::Print() {
 	cv->QueuePrint();
 
 }
+
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a reader-writer lock, FREE, with its counters at zero.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(char *debugName) {
+	name = debugName;
+	lock = new Lock(debugName);
+	readersOk = new Condition(debugName);
+	writersOk = new Condition(debugName);
+	upgradeOk = new Condition(debugName);
+	readers = 0;
+	writer = NULL;
+	waitingWriters = 0;
+	upgrading = FALSE;
+	numReads = numWrites = readWaits = writeWaits = 0;
+	numUpgrades = failedUpgrades = 0;
+}
+
+RWLock::~RWLock() {
+	delete upgradeOk;
+	delete writersOk;
+	delete readersOk;
+	delete lock;
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReadAcquire
+// 	Wait until there is no writer, and none waiting (or upgrading),
+//	then take a share of the lock.
+//----------------------------------------------------------------------
+
+void RWLock::ReadAcquire() {
+	lock->Acquire();
+	numReads++;
+	if (writer != NULL || waitingWriters > 0 || upgrading) {
+		readWaits++;
+		while (writer != NULL || waitingWriters > 0 || upgrading)
+			readersOk->Wait(lock);
+	}
+	readers++;
+	lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReadRelease
+// 	Give back a share of the lock.  If that leaves only a reader
+//	that is upgrading, let it go on; if it leaves no readers, let
+//	a writer in.
+//----------------------------------------------------------------------
+
+void RWLock::ReadRelease() {
+	lock->Acquire();
+	ASSERT(readers > 0);
+	readers--;
+	if (upgrading && readers == 1)
+		upgradeOk->Signal(lock);
+	else if (readers == 0 && waitingWriters > 0)
+		writersOk->Signal(lock);
+	lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::WriteAcquire
+// 	Wait until no one holds the lock, then take all of it.
+//----------------------------------------------------------------------
+
+void RWLock::WriteAcquire() {
+	lock->Acquire();
+	numWrites++;
+	if (writer != NULL || readers > 0) {
+		writeWaits++;
+		waitingWriters++;
+		while (writer != NULL || readers > 0)
+			writersOk->Wait(lock);
+		waitingWriters--;
+	}
+	writer = currentThread;
+	lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::WriteRelease
+// 	Give back the lock: to the next writer, if there is one waiting,
+//	otherwise to all the waiting readers.
+//----------------------------------------------------------------------
+
+void RWLock::WriteRelease() {
+	lock->Acquire();
+	ASSERT(writer == currentThread);
+	writer = NULL;
+	if (waitingWriters > 0)
+		writersOk->Signal(lock);
+	else
+		readersOk->Broadcast(lock);
+	lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::Upgrade
+// 	Turn our read hold into a write hold, once the other readers
+//	have left.  New readers wait meanwhile, and we go ahead of any
+//	waiting writers, which are waiting for us to leave anyway.
+//
+// Returns:
+//	FALSE, still holding the read lock, if another reader is already
+//	upgrading.
+//----------------------------------------------------------------------
+
+bool RWLock::Upgrade() {
+	lock->Acquire();
+	ASSERT(readers > 0 && writer == NULL);
+	if (upgrading) {
+		failedUpgrades++;
+		lock->Release();
+		return FALSE;
+	}
+	upgrading = TRUE;
+	while (readers > 1)
+		upgradeOk->Wait(lock);
+	upgrading = FALSE;
+	readers--;
+	writer = currentThread;
+	numUpgrades++;
+	lock->Release();
+	return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RWLock::Downgrade
+// 	Turn our write hold into a read hold.  Waiting readers come in
+//	with us, unless a writer is waiting, as in ReadAcquire.
+//----------------------------------------------------------------------
+
+void RWLock::Downgrade() {
+	lock->Acquire();
+	ASSERT(writer == currentThread);
+	writer = NULL;
+	readers++;
+	if (waitingWriters == 0)
+		readersOk->Broadcast(lock);
+	lock->Release();
+}
+
+void RWLock::Print() {
+	printf("RWLock %s: %d reads (%d waited), %d writes (%d waited), "
+		"%d upgrades (%d failed)\n", name, numReads, readWaits,
+		numWrites, writeWaits, numUpgrades, failedUpgrades);
+}
+
+//----------------------------------------------------------------------
+// SeqLock::SeqLock
+// 	Initialize a sequence lock, with no write in progress.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+SeqLock::SeqLock(char *debugName) {
+	name = debugName;
+	writeLock = new Lock(debugName);
+	sequence = 0;
+	numReads = numWrites = numRetries = 0;
+}
+
+SeqLock::~SeqLock() {
+	delete writeLock;
+}
+
+//----------------------------------------------------------------------
+// SeqLock::ReadBegin
+// 	Wait for any write in progress to finish, and return the
+//	sequence number, for ReadRetry.  A reader has nothing to do but
+//	wait for the writer, so it gives up the CPU meanwhile.
+//----------------------------------------------------------------------
+
+unsigned int SeqLock::ReadBegin() {
+	while (sequence & 1)
+		currentThread->Yield();
+	return sequence;
+}
+
+//----------------------------------------------------------------------
+// SeqLock::ReadRetry
+// 	Return TRUE if a write has started since ReadBegin, in which case
+//	what was read may be inconsistent, and must be read again.
+//
+//	"start" is what ReadBegin returned
+//----------------------------------------------------------------------
+
+bool SeqLock::ReadRetry(unsigned int start) {
+	if (sequence != start) {
+		numRetries++;
+		return TRUE;
+	}
+	numReads++;
+	return FALSE;
+}
+
+//----------------------------------------------------------------------
+// SeqLock::WriteLock, SeqLock::WriteUnlock
+// 	Start and finish changing the structure.  The sequence number
+//	is odd in between.
+//----------------------------------------------------------------------
+
+void SeqLock::WriteLock() {
+	writeLock->Acquire();
+	sequence++;
+}
+
+void SeqLock::WriteUnlock() {
+	sequence++;
+	numWrites++;
+	writeLock->Release();
+}
+
+void SeqLock::Print() {
+	printf("SeqLock %s: %d reads (%d retried), %d writes\n", name,
+		numReads, numRetries, numWrites);
+}
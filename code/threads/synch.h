@@ -20,6 +20,8 @@
 #include "copyright.h"
 #include "thread.h"
 #include "list.h"
+#include "runqueue.h"
+#include "lockprof.h"
 
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
@@ -48,7 +50,9 @@ class Semaphore {
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
-    List *queue;       // threads waiting in P() for the value to be > 0
+    RunQueue *queue;   // threads waiting in P() for the value to be > 0,
+		       // all at one level, so first come first served
+    PROFILE(SynchProfile *profile;)
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -57,11 +61,19 @@ class Semaphore {
 //	Acquire -- wait until the lock is FREE, then set it to BUSY
 //
 //	Release -- set lock to be FREE, waking up a thread waiting
-//		in Acquire if necessary
+//		in Acquire if necessary (the lock is handed straight to
+//		that thread, and so is never FREE in between)
 //
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// Waiting threads get the lock in order of priority.  A thread waiting
+// for a lock donates its priority to the holder, for as long as the
+// holder has the lock -- and on to the holder of the lock *it* is
+// waiting for, and so on -- so that a low priority holder can't be
+// kept off the CPU by medium priority threads while a high priority
+// thread waits for it.
 
 class Lock {
   public:
@@ -79,10 +91,22 @@ class Lock {
 
   private:
     char* name;				// for debugging
-    // plus some other stuff you'll need to define
-    bool locked;
-    int threadID;
-    List* queue;
+    Thread *holder;			// the thread holding the lock;
+					// NULL if it is FREE
+    RunQueue *queue;			// threads waiting in Acquire, by
+					// priority
+    Lock *nextHeld;			// next lock held by "holder"
+    PROFILE(SynchProfile *profile;)
+    PROFILE(int heldSince;)		// when "holder" got the lock
+
+    void GiveTo(Thread *thread);	// make "thread" the holder
+    void Enqueue(Thread *thread);	// make "thread" wait for the lock
+    void Donate(int pri);		// raise the holder (and whoever it
+					// is waiting for) to priority "pri"
+    void AcquireFor(Thread *thread);	// have sleeping "thread" acquire
+					// the lock, as if it called Acquire
+    friend class Thread;		// for Thread::UpdatePriority
+    friend class Condition;		// for AcquireFor
 };
 
 // The following class defines a "condition variable".  A condition
@@ -105,9 +129,11 @@ class Lock {
 //
 // In Nachos, condition variables are assumed to obey *Mesa*-style
 // semantics.  When a Signal or Broadcast wakes up another thread,
-// it simply puts the thread on the ready list, and it is the responsibility
-// of the woken thread to re-acquire the lock (this re-acquire is
-// taken care of within Wait()).  By contrast, some define condition
+// the thread has to re-acquire the lock before it returns from Wait().
+// So rather than put the thread on the ready list, only for it to
+// block on the lock again, Signal moves it straight to the lock's
+// queue ("wait morphing"), and it is woken when it has been handed
+// the lock.  By contrast, some define condition
 // variables according to *Hoare*-style semantics -- where the signalling
 // thread gives up control over the lock and the CPU to the woken thread,
 // which runs immediately and gives back control over the lock to the 
@@ -135,9 +161,9 @@ class Condition {
 
   private:
     char* name;
-    int numSleepers;
-    List* queue;
-    // plus some other stuff you'll need to define
+    RunQueue* queue;			// threads waiting, woken highest
+					// priority first
+    PROFILE(SynchProfile *profile;)
 };
 
 /**
@@ -157,6 +183,99 @@ private:
 	int finished;
 	Condition *cv;
 	Lock *lock;
+	PROFILE(SynchProfile *profile;)
+};
+
+// The following class defines a "reader-writer lock": any number of
+// readers may hold it at once, or one writer.
+//
+//	ReadAcquire/ReadRelease -- take/give back a share of the lock
+//
+//	WriteAcquire/WriteRelease -- take/give back the whole lock
+//
+//	Upgrade -- turn a read hold into a write hold, waiting for the
+//		other readers to leave.  Only one reader can be upgrading
+//		at a time (two would wait for each other forever), so it
+//		returns FALSE, still holding the read lock, if another one
+//		already is; the caller then has to ReadRelease and
+//		WriteAcquire instead.
+//
+//	Downgrade -- turn a write hold into a read hold, letting in
+//		waiting readers, but without letting a writer in between.
+//
+// Writers are preferred: once a writer is waiting, new readers wait
+// behind it, so a steady stream of readers can't starve writers.
+
+class RWLock {
+  public:
+    RWLock(char *debugName);		// initialize lock to be FREE
+    ~RWLock();
+    char* getName() { return name; }
+
+    void ReadAcquire();
+    void ReadRelease();
+    void WriteAcquire();
+    void WriteRelease();
+    bool Upgrade();			// reader to writer; FALSE if another
+					// reader got in first
+    void Downgrade();			// writer to reader
+
+    void Print();			// print the contention counters
+
+  private:
+    char *name;
+    Lock *lock;				// protects the fields below
+    Condition *readersOk;		// readers waiting for the writers
+    Condition *writersOk;		// writers waiting for everyone
+    Condition *upgradeOk;		// the upgrader, waiting for the
+					// other readers to leave
+    int readers;			// threads holding a read lock
+    Thread *writer;			// the thread holding the write lock
+    int waitingWriters;			// threads waiting in WriteAcquire
+    bool upgrading;			// a reader is waiting in Upgrade
+
+    int numReads, numWrites;		// acquisitions
+    int readWaits, writeWaits;		// ... that had to wait
+    int numUpgrades, failedUpgrades;
+};
+
+// The following class defines a "sequence lock", for small structures
+// that are read far more often than they are written, such as a
+// snapshot of some statistics.  Writers take a lock, and bump a
+// sequence number before and after changing the structure; readers
+// don't lock anything, they just read the structure, then check that
+// the sequence number is even (no write in progress) and unchanged,
+// and if not, read it again:
+//
+//	do {
+//	    seq = seqLock->ReadBegin();
+//	    ... copy the structure ...
+//	} while (seqLock->ReadRetry(seq));
+//
+// So readers never hold up a writer, or each other.  The reader must
+// not follow pointers in the structure, since it may be half-written.
+
+class SeqLock {
+  public:
+    SeqLock(char *debugName);
+    ~SeqLock();
+    char* getName() { return name; }
+
+    unsigned int ReadBegin();		// start reading; returns the
+					// sequence number to check
+    bool ReadRetry(unsigned int start);	// TRUE if the structure changed
+					// since ReadBegin returned "start"
+    void WriteLock();
+    void WriteUnlock();
+
+    void Print();			// print the contention counters
+
+  private:
+    char *name;
+    Lock *writeLock;			// writers take turns
+    unsigned int sequence;		// odd while a write is in progress
 
+    int numReads, numWrites;		// completed reads, and writes
+    int numRetries;			// reads that had to be done again
 };
 #endif // SYNCH_H
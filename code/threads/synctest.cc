@@ -8,6 +8,7 @@
 #include "synctest.h"
 #include "ts.h"
 #include "system.h"
+#include "freelist.h"
 Condition *cv_fill = new Condition("cv_producer");
 Condition *cv_empty = new Condition("cv_consumer");
 Lock *lock_cv_pc = new Lock("lock_cv_pc");
@@ -148,3 +149,290 @@ void testBarrier() {
 }
 
 
+
+/**
+ * Lock handoff benchmark
+ *
+ * Each of benchWorkers workers runs its critical section benchRounds
+ * times, yielding inside it -- as if its time slice ran out -- so the
+ * other workers pile up waiting.  Run once with a mutex made
+ * from a Semaphore, which, like the old Lock, sets the mutex free on
+ * release and lets the releasing thread take it straight back while
+ * the woken one is still on the ready list; then with Lock, which hands
+ * the lock to the thread it wakes.  Prints the context switches per
+ * critical section for each.
+ */
+#define benchWorkers 4
+#define benchRounds 100
+
+static Semaphore *bench_sema = new Semaphore("bench_sema", 1);
+static Lock *bench_lock = new Lock("bench_lock");
+static int bench_done;
+static int bench_start;
+
+static void bench_report(char *what) {
+	int sections = benchWorkers * benchRounds;
+	int switches = scheduler->NumSwitches() - bench_start;
+
+	printf("%s: %d critical sections, %d context switches, %d.%02d per section\n",
+		what, sections, switches, switches / sections,
+		switches * 100 / sections % 100);
+}
+
+static void bench_lock_worker(int arg) {
+	for(int i = 0; i < benchRounds; i++) {
+		bench_lock->Acquire();
+		currentThread->Yield();
+		bench_lock->Release();
+	}
+	if(++bench_done == benchWorkers)
+		bench_report("Lock (handoff)");
+}
+
+static void bench_sema_worker(int arg) {
+	for(int i = 0; i < benchRounds; i++) {
+		bench_sema->P();
+		currentThread->Yield();
+		bench_sema->V();
+	}
+	if(++bench_done == benchWorkers) {
+		bench_report("Semaphore (barging)");
+		bench_done = 0;
+		bench_start = scheduler->NumSwitches();
+		for(int j = 0; j < benchWorkers; j++)
+			(new Thread("lock_worker"))->Fork(bench_lock_worker, j);
+	}
+}
+
+void lock_handoff_benchmark() {
+	bench_done = 0;
+	bench_start = scheduler->NumSwitches();
+	for(int j = 0; j < benchWorkers; j++)
+		(new Thread("sema_worker"))->Fork(bench_sema_worker, j);
+}
+
+/**
+ * Reader-writer benchmark
+ *
+ * rwThreads threads each read or update a pair of counters rwRounds
+ * times, yielding halfway through, first under an RWLock and then
+ * under a SeqLock, with more readers to each writer every time.  The
+ * writers keep the two counters equal, so a reader that sees them
+ * differ has been let in during a write.  Prints the operations per
+ * thousand ticks of simulated time for each reader:writer ratio, and
+ * the locks' contention counters.
+ */
+#define rwThreads 8
+#define rwRounds 50
+#define rwRatios 3
+
+static int rw_writers[rwRatios] = { 4, 2, 1 };	// 1:1, 3:1, 7:1
+static RWLock *rw_lock = new RWLock("rw_lock");
+static SeqLock *rw_seq = new SeqLock("rw_seq");
+static int rw_data[2];
+static int rw_phase = -1;
+static int rw_done;
+static int rw_start;
+static int rw_switches;
+
+static void rw_next_phase();
+
+static void rw_read() {
+	int first, second;
+
+	if (rw_phase < rwRatios) {
+		rw_lock->ReadAcquire();
+		first = rw_data[0];
+		currentThread->Yield();
+		second = rw_data[1];
+		rw_lock->ReadRelease();
+	} else {
+		unsigned int seq;
+
+		do {
+			seq = rw_seq->ReadBegin();
+			first = rw_data[0];
+			currentThread->Yield();
+			second = rw_data[1];
+		} while (rw_seq->ReadRetry(seq));
+	}
+	ASSERT(first == second);
+}
+
+static void rw_write() {
+	if (rw_phase < rwRatios)
+		rw_lock->WriteAcquire();
+	else
+		rw_seq->WriteLock();
+	rw_data[0]++;
+	currentThread->Yield();
+	rw_data[1]++;
+	if (rw_phase < rwRatios)
+		rw_lock->WriteRelease();
+	else
+		rw_seq->WriteUnlock();
+}
+
+static void rw_worker(int isWriter) {
+	for(int i = 0; i < rwRounds; i++) {
+		if (isWriter)
+			rw_write();
+		else
+			rw_read();
+	}
+	if(++rw_done == rwThreads)
+		rw_next_phase();
+}
+
+static void rw_next_phase() {
+	if (rw_phase >= 0) {
+		int ops = rwThreads * rwRounds;
+		int ticks = stats->totalTicks - rw_start;
+		int writers = rw_writers[rw_phase % rwRatios];
+
+		printf("%s %d:%d readers:writers: %d ops in %d ticks "
+			"(%d per 1000 ticks), %d context switches\n",
+			(rw_phase < rwRatios) ? "RWLock" : "SeqLock",
+			rwThreads - writers, writers, ops, ticks,
+			ops * 1000 / ticks,
+			scheduler->NumSwitches() - rw_switches);
+		if (rw_phase == rwRatios - 1)
+			rw_lock->Print();
+		else if (rw_phase == 2 * rwRatios - 1)
+			rw_seq->Print();
+	}
+	if (++rw_phase == 2 * rwRatios)
+		return;
+	rw_done = 0;
+	rw_start = stats->totalTicks;
+	rw_switches = scheduler->NumSwitches();
+	for(int j = 0; j < rwThreads; j++)
+		(new Thread("rw_worker"))->Fork(rw_worker,
+			j < rw_writers[rw_phase % rwRatios]);
+}
+
+void rwlock_benchmark() {
+	rw_phase = -1;
+	rw_next_phase();
+}
+
+/**
+ * Context switch benchmark
+ *
+ * Two threads hand the CPU back and forth switchRounds times: first
+ * by yielding to each other, then by waking each other up with a pair
+ * of semaphores and going to sleep.  Prints the context switches per
+ * host second for each, and how many slabs the free lists had to
+ * allocate meanwhile -- after the first few switches, none should be
+ * needed, as switching threads doesn't touch the heap.
+ */
+#define switchRounds 100000
+
+static Semaphore *switch_ping = new Semaphore("switch_ping", 0);
+static Semaphore *switch_pong = new Semaphore("switch_pong", 0);
+static int switch_done;
+static int switch_start;
+static int switch_slabs;
+static double switch_host;
+
+static void switch_begin() {
+	switch_done = 0;
+	switch_start = scheduler->NumSwitches();
+	switch_slabs = FreeList::TotalSlabs();
+	switch_host = HostTime();
+}
+
+static void switch_report(char *what) {
+	int switches = scheduler->NumSwitches() - switch_start;
+	double seconds = HostTime() - switch_host;
+
+	printf("%s: %d context switches in %.3f host seconds, "
+		"%.0f per second, %d slabs allocated\n",
+		what, switches, seconds,
+		(seconds > 0) ? switches / seconds : 0.0,
+		FreeList::TotalSlabs() - switch_slabs);
+}
+
+static void switch_sema_worker(int isPong) {
+	for(int i = 0; i < switchRounds; i++) {
+		if (isPong) {
+			switch_pong->P();
+			switch_ping->V();
+		} else {
+			switch_pong->V();
+			switch_ping->P();
+		}
+	}
+	if(++switch_done == 2)
+		switch_report("Semaphore");
+}
+
+static void switch_yield_worker(int isPong) {
+	for(int i = 0; i < switchRounds; i++)
+		currentThread->Yield();
+	if(++switch_done < 2)
+		return;
+	switch_report("Yield");
+	switch_begin();
+	(new Thread("switch_ping"))->Fork(switch_sema_worker, 0);
+	(new Thread("switch_pong"))->Fork(switch_sema_worker, 1);
+}
+
+void context_switch_benchmark() {
+	switch_begin();
+	(new Thread("switch_ping"))->Fork(switch_yield_worker, 0);
+	(new Thread("switch_pong"))->Fork(switch_yield_worker, 1);
+}
+
+/**
+ * Semaphore wake order test
+ *
+ * "order_first" takes a lock, then waits on a semaphore, and
+ * "order_second" waits on it behind "order_first".  Then
+ * "order_donor", at the highest priority, blocks on the lock, which
+ * lends its priority to "order_first" while it waits on the semaphore.
+ * A semaphore wakes its waiters in the order they came, whatever their
+ * priority, so "order_first" must still be woken first.
+ */
+static Semaphore *order_sema = new Semaphore("order_sema", 0);
+static Lock *order_lock = new Lock("order_lock");
+static int order_waiting;
+static int order_woken[2];
+static int order_count;
+
+static void order_waiter(int which) {
+	if (which == 0)
+		order_lock->Acquire();
+	order_waiting++;
+	order_sema->P();
+	order_woken[order_count++] = which;
+	if (which == 0)
+		order_lock->Release();
+}
+
+static void order_donor(int arg) {
+	order_waiting++;
+	order_lock->Acquire();			// lends order_first our priority
+	order_lock->Release();
+}
+
+void semaphore_order_test() {
+	Thread *donor = new Thread("order_donor");
+
+	order_waiting = order_count = 0;
+	(new Thread("order_first"))->Fork(order_waiter, 0);
+	(new Thread("order_second"))->Fork(order_waiter, 1);
+	while (order_waiting < 2)		// both asleep on the semaphore
+		currentThread->Yield();
+	donor->setPriority(HIGEST_PRIORITY);
+	donor->Fork(order_donor, 0);
+	while (order_waiting < 3)		// and the donor on the lock
+		currentThread->Yield();
+
+	order_sema->V();
+	order_sema->V();
+	while (order_count < 2)
+		currentThread->Yield();
+	printf("Semaphore wake order: %d, %d\n", order_woken[0], order_woken[1]);
+	ASSERT(order_woken[0] == 0 && order_woken[1] == 1);
+}
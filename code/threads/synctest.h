@@ -12,5 +12,9 @@
 extern void producer_consumer_cv_lock();
 extern void producer_consumer_semaphore();
 extern void testBarrier();
+extern void lock_handoff_benchmark();
+extern void rwlock_benchmark();
+extern void context_switch_benchmark();
+extern void semaphore_order_test();
 
 #endif /* SYNCTEST_H_ */
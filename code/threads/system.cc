@@ -18,6 +18,8 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+StackPool *stackPool;			// thread stacks for reuse
+Alarm *alarmClock;			// wakes up sleeping threads
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -29,6 +31,15 @@ SynchDisk   *synchDisk;
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+FrameTable *frameTable;	// who has which frame of "machine" memory
+#endif
+
+#ifdef VM
+Pager *pager;		// evicts pages to swap
+#endif
+
+#ifdef USE_TLB
+TLBManager *tlbManager;	// refills the TLB
 #endif
 
 #ifdef NETWORK
@@ -80,9 +91,21 @@ Initialize(int argc, char **argv)
     int argCount;
     char* debugArgs = "";
     bool randomYield = FALSE;
+    SchedPolicy *policy = NULL;		// how to schedule threads
+    int pooledStacks = StackPoolSize;	// thread stacks kept for reuse
+    char *threadStatsFile = NULL;	// where to write thread statistics
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    ExecEngine engine = InterpEngine;	// how to run user programs
+#endif
+#ifdef VM
+    ReplacementPolicy *replacement = NULL; // how to pick pages to evict
+#endif
+#ifdef USE_TLB
+    int tlbEntries = TLBSize;		// the shape of the TLB
+    int tlbWays = 0;			// 0 for fully associative
+    TLBReplacement tlbReplacement = TLBRandom;
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
@@ -107,10 +130,68 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-sched")) {
+	    ASSERT(argc > 1);
+	    policy = NewSchedPolicy(*(argv + 1));
+	    if (policy == NULL) {
+		printf("Unknown scheduling policy \"%s\"; use fifo, rr, "
+			"priority, mlfq or cfs.\n", *(argv + 1));
+		Exit(1);
+	    }
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-stacks")) {
+	    ASSERT(argc > 1);
+	    pooledStacks = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tstats")) {
+	    ASSERT(argc > 1);
+	    threadStatsFile = *(argv + 1);
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-bb"))
+	    engine = BlockEngine;
+	else if (!strcmp(*argv, "-jit"))
+	    engine = JitEngine;
+#endif
+#ifdef VM
+	if (!strcmp(*argv, "-vm")) {
+	    ASSERT(argc > 1);
+	    replacement = NewReplacementPolicy(*(argv + 1));
+	    if (replacement == NULL) {
+		printf("Unknown page replacement policy \"%s\"; use fifo, "
+			"clock, eclock or aging.\n", *(argv + 1));
+		Exit(1);
+	    }
+	    argCount = 2;
+	}
+#endif
+#ifdef USE_TLB
+	if (!strcmp(*argv, "-tlb")) {
+	    ASSERT(argc > 1);
+	    tlbEntries = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tlbways")) {
+	    ASSERT(argc > 1);
+	    tlbWays = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tlbrepl")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "random"))
+		tlbReplacement = TLBRandom;
+	    else if (!strcmp(*(argv + 1), "fifo"))
+		tlbReplacement = TLBFifo;
+	    else if (!strcmp(*(argv + 1), "lru"))
+		tlbReplacement = TLBLru;
+	    else {
+		printf("Unknown TLB replacement \"%s\"; use random, fifo "
+			"or lru.\n", *(argv + 1));
+		Exit(1);
+	    }
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -131,8 +212,14 @@ Initialize(int argc, char **argv)
 
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
+    if (threadStatsFile != NULL)		// and write out each thread's
+	ThreadStats::StartDump(threadStatsFile);
     interrupt = new Interrupt;			// start up interrupt handling
-    scheduler = new Scheduler();		// initialize the ready queue
+    stackPool = new StackPool(StackSize * sizeof(int), pooledStacks);
+    if (policy == NULL)
+	policy = new FifoPolicy;
+    scheduler = new Scheduler(policy);		// initialize the ready queue
+    alarmClock = new Alarm;			// for Thread::SleepFor
     if (randomYield)				// start the timer (if needed)
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
@@ -145,13 +232,29 @@ Initialize(int argc, char **argv)
     currentThread->setStatus(RUNNING);
 //    currentThread->setTimeSlice(1);
     currentThread->setPriority(0);
-    //scheduler->AddToAllThreadList(currentThread);
 
     interrupt->Enable();
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
     
 #ifdef USER_PROGRAM
-    machine = new Machine(debugUserProg);	// this must come first
+#ifdef USE_TLB
+    if (tlbWays <= 0 || tlbWays > tlbEntries)
+	tlbWays = tlbEntries;
+    machine = new Machine(debugUserProg, engine, tlbEntries, tlbWays);
+#else
+    machine = new Machine(debugUserProg, engine); // this must come first
+#endif
+    frameTable = new FrameTable(NumPhysPages);
+#endif
+
+#ifdef VM
+    if (replacement == NULL)
+	replacement = new ClockReplacement;
+    pager = new Pager(replacement);
+#endif
+
+#ifdef USE_TLB
+    tlbManager = new TLBManager(tlbReplacement);
 #endif
 
 #ifdef FILESYS
@@ -179,7 +282,16 @@ Cleanup()
     delete postOffice;
 #endif
     
+#ifdef USE_TLB
+    delete tlbManager;
+#endif
+
+#ifdef VM
+    delete pager;
+#endif
+
 #ifdef USER_PROGRAM
+    delete frameTable;
     delete machine;
 #endif
 
@@ -192,8 +304,10 @@ Cleanup()
 #endif
     
     delete timer;
+    delete alarmClock;
     delete scheduler;
     delete interrupt;
+    delete stackPool;
     
     Exit(0);
 }
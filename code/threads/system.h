@@ -15,6 +15,8 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "stackpool.h"
+#include "alarm.h"
 
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv); 	// Initialization,
@@ -28,10 +30,24 @@ extern Scheduler *scheduler;			// the ready list
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
+extern StackPool *stackPool;			// thread stacks for reuse
+extern Alarm *alarmClock;			// wakes up sleeping threads
 
 #ifdef USER_PROGRAM
 #include "machine.h"
+#include "frametable.h"
 extern Machine* machine;	// user program memory and registers
+extern FrameTable *frameTable;	// who has which frame of "machine" memory
+#endif
+
+#ifdef VM
+#include "pager.h"
+extern Pager *pager;		// evicts pages to swap
+#endif
+
+#ifdef USE_TLB
+#include "tlbmanager.h"
+extern TLBManager *tlbManager;	// refills the TLB
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB 
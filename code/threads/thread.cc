@@ -42,8 +42,19 @@ Thread::Thread(char* threadName)
     stack = NULL;
     status = JUST_CREATED;
     tid = alloc_tidmap();
-    scheduler->AddToAllThreadList(this);
+    if (tid >= 0)
+	scheduler->GetThreadTable()->Add(this);
     timeSlices = TIMESLICE_DEFAULT;
+    nextReady = prevReady = NULL;
+    readyQueue = NULL;
+    readyLevel = 0;
+    waitingFor = NULL;
+    heldLocks = NULL;
+    waitingCondition = NULL;
+    schedLevel = 0;
+    vruntime = 0;
+    vruntimeCarry = 0;
+    numSwitches = 0;
 
 #ifdef USER_PROGRAM
     uid = 0;//set to user id
@@ -53,6 +64,7 @@ Thread::Thread(char* threadName)
     uid = 0;
     priority = LOWEST_PRIORITY;//by default
 #endif
+    basePriority = priority;
 
 }
 
@@ -73,11 +85,13 @@ Thread::~Thread()
     DEBUG('t', "Deleting thread \"%s\"\n", name);
 
     ASSERT(this != currentThread);
-    if (stack != NULL) {
-
-    	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
-
-    	}
+    if (stack != NULL)
+	stackPool->Free(stack);		// keep it for the next Fork
+    if (tid >= 0) {
+	ThreadStats::Dump(this, TRUE);
+	scheduler->GetThreadTable()->Remove(this);
+	free_tidmap(tid);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -117,9 +131,7 @@ Thread::Fork(VoidFunctionPtr func, int arg)
 					// are disabled!
     	(void) interrupt->SetLevel(oldLevel);
     } else {
-			//free_tidmap();
-			int tid_max = TID_MAX_DEFAULT;
-			printf("Only allow %d threads exist.\n",tid_max);
+			printf("Only allow %d threads exist.\n",TID_MAX_DEFAULT);
 		}
 }    
 
@@ -136,12 +148,15 @@ Thread::Fork(VoidFunctionPtr func, int arg)
 // 	then you *may* need to increase the stack size.  You can avoid stack
 // 	overflows by not putting large data structures on the stack.
 // 	Don't do this: void foo() { int bigArray[10000]; ... }
+//
+//	When the stacks have real guard pages, an overflow faults as soon
+//	as it happens, so there is no need to check the fencepost.
 //----------------------------------------------------------------------
 
 void
 Thread::CheckOverflow()
 {
-    if (stack != NULL)
+    if (stack != NULL && !stackPool->Guarded())
 #ifdef HOST_SNAKE			// Stacks grow upward on the Snakes
 	ASSERT(stack[StackSize - 1] == STACK_FENCEPOST);
 #else
@@ -173,7 +188,6 @@ Thread::Finish ()
     
     DEBUG('t', "Finishing thread \"%s\"\n", getName());
 //    printf("See when does it finish..\n");
-    clear_bit(tid);
 
     threadToBeDestroyed = currentThread;
 
@@ -208,9 +222,6 @@ Thread::Yield ()
     ASSERT(this == currentThread);
     
     DEBUG('t', "Yielding thread \"%s\"\n", getName());
-#ifdef SCHED_PRIORITY
-    currentThread->setPriority(currentThread->getPriority() - 1);
-#endif
     nextThread = scheduler->FindNextToRun();//get a thread from the front of readList
     if (nextThread != NULL) {
 	scheduler->ReadyToRun(this);//add current thread to the end of readyList
@@ -219,6 +230,89 @@ Thread::Yield ()
     (void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Thread::ChargeTime
+// 	Account for CPU time used by this thread, in its virtual runtime
+//	(see the completely fair scheduling policy).  The higher the
+//	thread's priority, the slower its virtual runtime grows: at
+//	LOWEST_PRIORITY it is the CPU time itself, and it halves for each
+//	VRUNTIME_PRIO_STEP levels above that.
+//
+//	"ticks" is the simulated time the thread has just run for
+//----------------------------------------------------------------------
+
+void
+Thread::ChargeTime(int ticks)
+{
+    int shift = (LOWEST_PRIORITY - priority) / VRUNTIME_PRIO_STEP;
+
+    ticks += vruntimeCarry;
+    vruntime += ticks >> shift;
+    vruntimeCarry = ticks & ((1 << shift) - 1);
+}
+
+//----------------------------------------------------------------------
+// Thread::setPriority
+// 	Set the thread's own priority.  It still runs at the priority of
+//	any higher priority thread waiting for a lock it holds.
+//
+//	"pri" is the new base priority
+//----------------------------------------------------------------------
+
+void
+Thread::setPriority(int pri)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    basePriority = pri;
+    UpdatePriority();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Thread::UpdatePriority
+// 	Recompute the priority the thread is scheduled at: the highest
+//	of its base priority and those of the threads waiting for each
+//	lock it holds (which have been raised in turn by the threads
+//	waiting for them, and so on).
+//----------------------------------------------------------------------
+
+void
+Thread::UpdatePriority()
+{
+    int pri = basePriority;
+    Lock *lock;
+
+    for (lock = heldLocks; lock != NULL; lock = lock->nextHeld)
+	if (lock->queue->BestPriority() < pri)
+	    pri = lock->queue->BestPriority();
+    ChangePriority(pri);
+}
+
+//----------------------------------------------------------------------
+// Thread::ChangePriority
+// 	Set the priority the thread is scheduled at.  If it is waiting
+//	for a lock, or on a condition, or ready to run, it moves to its
+//	new place in line.  A semaphore's waiters stay where they are:
+//	they are woken in the order they came, whatever their priority.
+//
+//	"pri" is the new priority
+//----------------------------------------------------------------------
+
+void
+Thread::ChangePriority(int pri)
+{
+    if (pri == priority)
+	return;
+    priority = pri;
+    if (waitingFor != NULL)
+	waitingFor->queue->Requeue(this, pri);
+    else if (status == READY)
+	scheduler->GetPolicy()->PriorityChanged(this);
+    else if (waitingCondition != NULL)	// readyQueue is the condition's
+	readyQueue->Requeue(this, pri);
+}
+
 //----------------------------------------------------------------------
 // Thread::Sleep
 // 	Relinquish the CPU, because the current thread is blocked
@@ -237,9 +331,11 @@ Thread::Yield ()
 //	disable interrupts for atomicity.   We need interrupts off 
 //	so that there can't be a time slice between pulling the first thread
 //	off the ready list, and switching to it.
+//
+//	"reason" is what the thread is waiting for, for its statistics
 //----------------------------------------------------------------------
 void
-Thread::Sleep ()
+Thread::Sleep (BlockReason reason)
 {
     Thread *nextThread;
     
@@ -249,12 +345,35 @@ Thread::Sleep ()
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
     status = BLOCKED;
+    account.Blocked(reason);
     while ((nextThread = scheduler->FindNextToRun()) == NULL)
 	interrupt->Idle();	// no one to run, wait for an interrupt
         
     scheduler->Run(nextThread); // returns when we've been signalled
 }
 
+//----------------------------------------------------------------------
+// Thread::SleepFor, Thread::SleepUntil
+// 	Put the current thread to sleep for a while, without using the
+//	CPU meanwhile; the alarm clock wakes it up.
+//
+//	"ticks" is how long to sleep, in simulated time
+//	"when" is the simulated time to sleep until
+//----------------------------------------------------------------------
+
+void
+Thread::SleepFor(int ticks)
+{
+    SleepUntil(stats->totalTicks + ticks);
+}
+
+void
+Thread::SleepUntil(int when)
+{
+    ASSERT(this == currentThread);
+    alarmClock->SleepUntil(when);
+}
+
 //----------------------------------------------------------------------
 // ThreadFinish, InterruptEnable, ThreadPrint
 //	Dummy functions because C++ does not allow a pointer to a member
@@ -269,10 +388,6 @@ void ThreadPrint(int arg){
 	Thread *t = (Thread *)arg;
 	t->Print();
 }
-void DecreasePriority(int arg) {
-	Thread *t = (Thread *)arg;
-	t->DecreasePriority();
-}
 
 //----------------------------------------------------------------------
 // Thread::StackAllocate
@@ -289,7 +404,7 @@ void DecreasePriority(int arg) {
 void
 Thread::StackAllocate (VoidFunctionPtr func, int arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    stack = stackPool->Alloc();
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
@@ -39,6 +39,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "threadstats.h"
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -51,8 +52,11 @@
 #define MachineStateSize 18 
 #define LOWEST_PRIORITY 255
 #define HIGEST_PRIORITY 0
-#define PRIORITY_FADE 0.75
+#define VRUNTIME_PRIO_STEP 32	// virtual runtime grows half as fast for
+				// each this many levels of higher priority
 #define TIMESLICE_DEFAULT 1;
+#define TIMESLICE_EXPIRED -1	// used up its time slice, and not yet
+				// given a new one by the scheduler
 
 // Size of the thread's private execution stack.
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
@@ -64,7 +68,10 @@ enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
 
 // external function, dummy routine whose sole job is to call Thread::Print
 extern void ThreadPrint(int arg);
-extern void DecreasePriority(int arg);
+
+class Lock;
+class Condition;
+class RunQueue;
 
 // The following class defines a "thread control block" -- which
 // represents a single thread of execution.
@@ -96,40 +103,44 @@ class Thread {
     void Fork(VoidFunctionPtr func, int arg); 	// Make thread run (*func)(arg)
     void Yield();  				// Relinquish the CPU if any 
 						// other thread is runnable
-    void Sleep();  				// Put the thread to sleep and 
-						// relinquish the processor
+    void Sleep(BlockReason reason = BlockedOther); // Put the thread to
+						// sleep and relinquish the
+						// processor
     void Finish();  				// The thread is done executing
+    void SleepFor(int ticks);			// Sleep for "ticks" of
+						// simulated time
+    void SleepUntil(int when);			// Sleep until the simulated
+						// time is "when"
     
     void CheckOverflow();   			// Check if thread has 
 						// overflowed its stack
     void setStatus(ThreadStatus st) { status = st; }
+    ThreadStatus getStatus() { return (status); }
     char* getName() { return (name); }
     // Added by Rye 2012/09/22
     // getTid
     // getUid
     int getTid() { return (tid); }
     int getUid() { return (uid); }
-    int getPriority() { return (priority); }
-    void setPriority(int pri) { priority = pri; }
+    int getPriority() { return (priority); }	// including any donated
+    int getBasePriority() { return (basePriority); }
+    void setPriority(int pri);			// set the base priority
     int getTimeSlice() { return (timeSlices); }
     void setTimeSlice(int slice) { timeSlices = slice; }
     void setDefaultTimeSlice() { timeSlices = TIMESLICE_DEFAULT; }
-
+    bool sliceExpired() { return (timeSlices == TIMESLICE_EXPIRED); }
+    int getSchedLevel() { return (schedLevel); }
+    void setSchedLevel(int level) { schedLevel = level; }
+    int getVruntime() { return (vruntime); }
+    void setVruntime(int vr) { vruntime = vr; }
+    void ChargeTime(int ticks);		// add CPU time to the vruntime
+    int getSwitches() { return (numSwitches); }
+    void countSwitch() { numSwitches++; }
+    ThreadStats *getStats() { return (&account); }
 
     //void Print() { printf("%s, ", name); }
-    void Print() {
-    	//Print information of this thread.
-    	//printf("Tid\t\tUid\tThread Name\Thread status",);
-    	printf("%2d\t%2d\t%.5s\t\t", tid, uid, name);
-    	switch(status) {
-    	case JUST_CREATED : printf("JUST CREATED\t\t");break;
-    	case RUNNING :	printf("RUNNING\t\t");break;
-    	case BLOCKED :	printf("BLOCKED\t\t");break;
-    	case READY 	 :	printf("READY\t\t");break;
-    	}
-    	printf("%3d\t\t%3d\n", priority, timeSlices);
-    }
-    void DecreasePriority() { priority *= PRIORITY_FADE; }
+    void Print() { account.Print(this); }	// one line of the table
+						// in Scheduler::Print
 
   private:
     // some of the private data for this class is listed above
@@ -143,8 +154,41 @@ class Thread {
     //Added by Rye 2012/09/22
     int tid;// thread id
     int uid;// user id
-    int priority;
+    int priority;			// what it is scheduled by: the best
+					// of its base priority and any
+					// donated by threads waiting for a
+					// lock it holds
+    int basePriority;			// its own priority
     int timeSlices;
+    int schedLevel;			// for the scheduling policy (the
+					// queue the thread is on, for MLFQ)
+    int vruntime;			// CPU time used, weighted by priority
+    int vruntimeCarry;			// CPU time too small to add to
+					// "vruntime" yet
+    int numSwitches;			// times the thread has been
+					// switched to
+    ThreadStats account;		// what it has done with its time
+
+    friend class Lock;
+    Lock *waitingFor;			// the lock it is blocked on, if any
+#ifdef LOCK_PROFILE
+    int lockWaitStart;			// and since when
+#endif
+    Lock *heldLocks;			// the locks it holds
+    void ChangePriority(int pri);	// set "priority", moving the thread
+					// to wherever it now belongs in the
+					// queue it waits on
+    void UpdatePriority();		// recompute "priority" from the base
+					// priority and the held locks
+
+    friend class Condition;
+    Condition *waitingCondition;	// the condition it waits on, if any
+
+    friend class RunQueue;
+    Thread *nextReady;			// next thread on the same run queue
+    Thread *prevReady;			// and the one before it
+    RunQueue *readyQueue;		// the run queue it is on, if any
+    int readyLevel;			// and the priority it is queued at
     void StackAllocate(VoidFunctionPtr func, int arg);
     					// Allocate a stack for thread.
 					// Used internally by Fork()
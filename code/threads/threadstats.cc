@@ -0,0 +1,276 @@
+// threadstats.cc
+//	Routines to account for what each thread does with its time,
+//	and to print and write out the accounts.
+//
+//	The scheduler calls Readied when a thread is put on the ready
+//	queue, Dispatched when it is switched to, and Switched and Ran
+//	when it is switched away from; Thread::Sleep calls Blocked.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "threadstats.h"
+#include "system.h"
+
+static char *statusNames[] = { "NEW", "RUN", "READY", "BLOCK" };
+static char *reasonNames[] = { "other", "semaphore", "lock", "condition",
+			       "sleep" };
+
+static FILE *dumpFile = NULL;	// where the records go, if anywhere
+static bool dumpJson;		// as JSON, rather than CSV
+static int numDumped;		// records written so far
+
+//----------------------------------------------------------------------
+// ThreadStats::ThreadStats
+// 	Initialize the account of a new thread, with nothing in it.
+//----------------------------------------------------------------------
+
+ThreadStats::ThreadStats()
+{
+    int i;
+
+    systemTicks = userTicks = 0;
+    readyTicks = maxReadyTicks = numDispatches = 0;
+    numVoluntary = numInvoluntary = 0;
+    for (i = 0; i < NumBlockReasons; i++)
+	blockedTicks[i] = numBlocked[i] = 0;
+    since = 0;
+    reason = BlockedOther;
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::Ran
+// 	Charge the thread for CPU time.
+//
+//	"system" is the time it ran kernel code for
+//	"user" is the time it ran user code for
+//----------------------------------------------------------------------
+
+void
+ThreadStats::Ran(int system, int user)
+{
+    systemTicks += system;
+    userTicks += user;
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::Blocked
+// 	Note that the thread has gone to sleep, and why.
+//
+//	"why" is what it is waiting for
+//----------------------------------------------------------------------
+
+void
+ThreadStats::Blocked(BlockReason why)
+{
+    reason = why;
+    numBlocked[why]++;
+    since = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::Readied
+// 	Note that the thread has been put on the ready queue; if it
+//	was blocked, charge the time to what it was waiting for.
+//
+//	"wasBlocked" is TRUE if it was asleep, rather than new or running
+//----------------------------------------------------------------------
+
+void
+ThreadStats::Readied(bool wasBlocked)
+{
+    if (wasBlocked)
+	blockedTicks[reason] += stats->totalTicks - since;
+    since = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::Dispatched
+// 	Note that the thread is about to run, after waiting on the
+//	ready queue since it was readied.
+//----------------------------------------------------------------------
+
+void
+ThreadStats::Dispatched()
+{
+    int waited = stats->totalTicks - since;
+
+    readyTicks += waited;
+    if (waited > maxReadyTicks)
+	maxReadyTicks = waited;
+    numDispatches++;
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::Switched
+// 	Count a context switch away from the thread.
+//
+//	"preempted" is TRUE if the CPU was taken away from it (by the
+//		scheduler's time slice, or by a thread that should run
+//		first), rather than it yielding or going to sleep
+//----------------------------------------------------------------------
+
+void
+ThreadStats::Switched(bool preempted)
+{
+    if (preempted)
+	numInvoluntary++;
+    else
+	numVoluntary++;
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::PrintHeader, ThreadStats::Print
+// 	Print a table of accounts, one line per thread, like "top":
+//	its share of the CPU time used so far, CPU time in the kernel
+//	and in user mode, average and longest wait on the ready queue,
+//	switches away from it, and time blocked for each reason.
+//
+//	"thread" is the thread whose account this is
+//----------------------------------------------------------------------
+
+void
+ThreadStats::PrintHeader()
+{
+    printf("%5s %-12s %-5s %3s %5s %8s %8s %6s %6s %5s %5s "
+	"%7s %7s %7s %7s %7s\n", "TID", "NAME", "STATE", "PRI", "%CPU",
+	"SYSTEM", "USER", "RDYAVG", "RDYMAX", "VOL", "INVOL",
+	"SEMA", "LOCK", "COND", "SLEEP", "OTHER");
+}
+
+void
+ThreadStats::Print(Thread *thread)
+{
+    int busy = stats->systemTicks + stats->userTicks;
+
+    printf("%5d %-12.12s %-5s %3d %5.1f %8d %8d %6d %6d %5d %5d "
+	"%7d %7d %7d %7d %7d\n", thread->getTid(), thread->getName(),
+	statusNames[thread->getStatus()], thread->getPriority(),
+	(busy > 0) ? CpuTicks() * 100.0 / busy : 0.0,
+	systemTicks, userTicks,
+	(numDispatches > 0) ? readyTicks / numDispatches : 0, maxReadyTicks,
+	numVoluntary, numInvoluntary,
+	blockedTicks[BlockedSemaphore], blockedTicks[BlockedLock],
+	blockedTicks[BlockedCondition], blockedTicks[BlockedSleep],
+	blockedTicks[BlockedOther]);
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::StartDump
+// 	Open the file that the threads' records are to be written to,
+//	and write the start of it.
+//
+//	"fileName" is the UNIX file to write; JSON if it ends in ".json"
+//----------------------------------------------------------------------
+
+void
+ThreadStats::StartDump(char *fileName)
+{
+    int length = strlen(fileName);
+    int i;
+
+    dumpFile = fopen(fileName, "w");
+    if (dumpFile == NULL) {
+	printf("Can't write thread statistics to \"%s\".\n", fileName);
+	return;
+    }
+    dumpJson = (length >= 5 && !strcmp(fileName + length - 5, ".json"));
+    numDumped = 0;
+    if (dumpJson) {
+	fprintf(dumpFile, "[\n");
+	return;
+    }
+    fprintf(dumpFile, "tid,name,exited,priority,system_ticks,user_ticks,"
+	"ready_ticks,max_ready_ticks,dispatches,voluntary,involuntary");
+    for (i = 0; i < NumBlockReasons; i++)
+	fprintf(dumpFile, ",%s_blocked,%s_blocked_ticks", reasonNames[i],
+	    reasonNames[i]);
+    fprintf(dumpFile, "\n");
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::Dump
+// 	Write a thread's record, if records are being written.  Thread
+//	names are program strings, so they are written as is, except
+//	that quotes are taken out.
+//
+//	"thread" is the thread whose record to write
+//	"exited" is TRUE if the thread is done, FALSE if it is still
+//		around when Nachos halts
+//----------------------------------------------------------------------
+
+void
+ThreadStats::Dump(Thread *thread, bool exited)
+{
+    ThreadStats *account = thread->getStats();
+    char name[32];
+    char *from, *to;
+    int i;
+
+    if (dumpFile == NULL)
+	return;
+    for (from = thread->getName(), to = name;
+	    *from != '\0' && to < name + sizeof(name) - 1; from++)
+	if (*from != '"' && *from != '\\' && *from != ',' && *from >= ' ')
+	    *to++ = *from;
+    *to = '\0';
+
+    if (!dumpJson) {
+	fprintf(dumpFile, "%d,%s,%d,%d,%d,%d,%d,%d,%d,%d,%d",
+	    thread->getTid(), name, exited ? 1 : 0, thread->getPriority(),
+	    account->systemTicks, account->userTicks, account->readyTicks,
+	    account->maxReadyTicks, account->numDispatches,
+	    account->numVoluntary, account->numInvoluntary);
+	for (i = 0; i < NumBlockReasons; i++)
+	    fprintf(dumpFile, ",%d,%d", account->numBlocked[i],
+		account->blockedTicks[i]);
+	fprintf(dumpFile, "\n");
+    } else {
+	fprintf(dumpFile, "%s  {\"tid\": %d, \"name\": \"%s\", "
+	    "\"exited\": %s, \"priority\": %d,\n"
+	    "   \"system_ticks\": %d, \"user_ticks\": %d, "
+	    "\"ready_ticks\": %d, \"max_ready_ticks\": %d,\n"
+	    "   \"dispatches\": %d, \"voluntary\": %d, \"involuntary\": %d,\n"
+	    "   \"blocked\": {", (numDumped > 0) ? ",\n" : "",
+	    thread->getTid(), name, exited ? "true" : "false",
+	    thread->getPriority(), account->systemTicks, account->userTicks,
+	    account->readyTicks, account->maxReadyTicks,
+	    account->numDispatches, account->numVoluntary,
+	    account->numInvoluntary);
+	for (i = 0; i < NumBlockReasons; i++)
+	    fprintf(dumpFile, "%s\"%s\": {\"count\": %d, \"ticks\": %d}",
+		(i > 0) ? ", " : "", reasonNames[i], account->numBlocked[i],
+		account->blockedTicks[i]);
+	fprintf(dumpFile, "}}");
+    }
+    numDumped++;
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::FinishDump
+// 	Nachos is halting: write the records of the threads that are
+//	still around, and close the file.
+//----------------------------------------------------------------------
+
+static void
+DumpRunning(int arg)
+{
+    Thread *thread = (Thread *) arg;
+
+    ThreadStats::Dump(thread, FALSE);
+}
+
+void
+ThreadStats::FinishDump()
+{
+    if (dumpFile == NULL)
+	return;
+    scheduler->ChargeRunningThread();
+    scheduler->GetThreadTable()->Mapcar(DumpRunning);
+    if (dumpJson)
+	fprintf(dumpFile, "%s]\n", (numDumped > 0) ? "\n" : "");
+    fclose(dumpFile);
+    dumpFile = NULL;
+}
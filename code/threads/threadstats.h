@@ -0,0 +1,74 @@
+// threadstats.h
+//	Data structures for accounting for what each thread does with
+//	its time: how much CPU it uses, in the kernel and in user mode;
+//	how long it waits on the ready queue before it gets to run (its
+//	scheduling latency); how often it gives up the CPU itself, or
+//	has it taken away; and how long it is blocked, for each kind of
+//	thing it can block on.
+//
+//	The scheduler keeps the accounts up to date as threads change
+//	state, so it costs a few additions per context switch.
+//	Scheduler::Print shows every thread's account, and with
+//	"-tstats <file>", they are all written to a file for analysis
+//	elsewhere: as JSON if the file name ends in ".json", otherwise
+//	as CSV.  A thread's record is written when it is destroyed, and
+//	the records of the threads still around when Nachos halts.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADSTATS_H
+#define THREADSTATS_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// What a blocked thread is waiting for.
+
+enum BlockReason { BlockedOther, BlockedSemaphore, BlockedLock,
+		   BlockedCondition, BlockedSleep, NumBlockReasons };
+
+class Thread;
+
+// The following class defines the account of one thread.  All times
+// are in simulated ticks.
+
+class ThreadStats {
+  public:
+    ThreadStats();			// initialize an empty account
+
+    void Ran(int system, int user);	// it has used the CPU for a while
+    void Blocked(BlockReason reason);	// it has gone to sleep
+    void Readied(bool wasBlocked);	// it has been put on the ready queue
+    void Dispatched();			// it is about to run
+    void Switched(bool preempted);	// it has given up the CPU -- or
+					// had it taken away
+
+    int CpuTicks() { return systemTicks + userTicks; }
+
+    static void PrintHeader();		// print the column names for Print
+    void Print(Thread *thread);		// print one line for the thread
+
+    static void StartDump(char *fileName); // write records to "fileName"
+    static void Dump(Thread *thread, bool exited); // write the thread's
+					// record, if writing records at all
+    static void FinishDump();		// write the records of every thread
+					// left, and close the file
+
+  private:
+    int systemTicks;			// CPU time running kernel code
+    int userTicks;			// and running user code
+    int readyTicks;			// time on the ready queue
+    int maxReadyTicks;			// longest single wait on it
+    int numDispatches;			// times it has been run
+    int numVoluntary;			// times it gave up the CPU itself
+    int numInvoluntary;			// times it was preempted
+    int blockedTicks[NumBlockReasons];	// time blocked, for each reason
+    int numBlocked[NumBlockReasons];	// times blocked, for each reason
+
+    int since;				// when it was last readied or blocked
+    BlockReason reason;			// why it is blocked, if it is
+};
+
+#endif // THREADSTATS_H
@@ -0,0 +1,108 @@
+// threadtable.cc
+//	Routines to keep track of every thread, by thread id.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "threadtable.h"
+
+//----------------------------------------------------------------------
+// ThreadTable::ThreadTable
+// 	Initialize a thread table, with no threads in it.
+//
+//	"maxThreads" is the number of tids the table has room for
+//----------------------------------------------------------------------
+
+ThreadTable::ThreadTable(int maxThreads)
+{
+    int i;
+
+    size = maxThreads;
+    table = new Thread *[size];
+    for (i = 0; i < size; i++)
+	table[i] = NULL;
+    numThreads = 0;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::~ThreadTable
+// 	De-allocate the table; the threads still in it belong to
+//	someone else.
+//----------------------------------------------------------------------
+
+ThreadTable::~ThreadTable()
+{
+    delete [] table;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Add
+// 	Put a thread in the slot for its tid, which must be free.
+//
+//	"thread" is the thread to add
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Add(Thread *thread)
+{
+    int tid = thread->getTid();
+
+    ASSERT((tid >= 0) && (tid < size) && (table[tid] == NULL));
+    table[tid] = thread;
+    numThreads++;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Remove
+// 	Take a thread out of the table.
+//
+//	"thread" is the thread to remove; it must be in the table
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Remove(Thread *thread)
+{
+    int tid = thread->getTid();
+
+    ASSERT((tid >= 0) && (tid < size) && (table[tid] == thread));
+    table[tid] = NULL;
+    numThreads--;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Lookup
+// 	Return the thread with a given tid, or NULL if there is none.
+//
+//	"tid" is the thread id to look up
+//----------------------------------------------------------------------
+
+Thread *
+ThreadTable::Lookup(int tid)
+{
+    if ((tid < 0) || (tid >= size))
+	return NULL;
+    return table[tid];
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Mapcar
+// 	Apply a function to each thread in the table, in order of tid.
+//	Stops looking once every thread has been seen, so it is quick
+//	when the tids in use are small, as they usually are.
+//
+//	"func" is the procedure to apply to each thread
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Mapcar(VoidFunctionPtr func)
+{
+    int tid, seen = 0;
+
+    for (tid = 0; (tid < size) && (seen < numThreads); tid++)
+	if (table[tid] != NULL) {
+	    seen++;
+	    (*func)((int) table[tid]);
+	}
+}
@@ -0,0 +1,44 @@
+// threadtable.h
+//	Data structures for the table of every thread in the system,
+//	indexed by thread id.
+//
+//	A thread is in the table from when it is given a tid until it
+//	is deleted and the tid is freed.  Since tids are small integers
+//	(see tid.h), the table is just an array with a slot per tid:
+//	adding, removing and looking up a thread take constant time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADTABLE_H
+#define THREADTABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "thread.h"
+
+// The following class defines a thread table.
+
+class ThreadTable {
+  public:
+    ThreadTable(int maxThreads);	// initialize an empty table, for
+					// tids from 0 to maxThreads - 1
+    ~ThreadTable();			// de-allocate the table (but not
+					// the threads in it)
+
+    void Add(Thread *thread);		// put "thread" in its tid's slot
+    void Remove(Thread *thread);	// take it out again
+    Thread *Lookup(int tid);		// the thread with "tid"; NULL if none
+    int NumThreads() { return numThreads; }
+
+    void Mapcar(VoidFunctionPtr func);	// apply "func" to every thread,
+					// in order of tid
+
+  private:
+    Thread **table;			// table[tid] is that thread, or NULL
+    int size;				// number of slots
+    int numThreads;			// slots in use
+};
+
+#endif // THREADTABLE_H
@@ -4,60 +4,145 @@
  * Rye
  * rye.y.cn@gmail.com
  * 2012/09/23
+ *
+ * Ids are handed out in increasing order from the last one allocated,
+ * wrapping around to 0 at TID_MAX_DEFAULT, as Linux does with pids, so
+ * that an id is not reused as soon as it is freed.  Both alloc and free
+ * touch one word at each of the three levels of the map.
  */
 
 #include "tid.h"
 
 static int last_tid = -1;
-static BitMap *_tidmap = new BitMap(TID_MAX_DEFAULT);
+static struct tidmap _tidmap;
+static bool tidmap_ready = FALSE;
 
-void free_tidmap(int tid) {
-    //_tidmap->~BitMap();
-}
-int alloc_tidmap() {
-    int tid_max, last, tid;
-    tid_max = TID_MAX_DEFAULT;
-    last = last_tid;
-    tid = last + 1;
-
-    if(tid >= tid_max) {
-	printf("tid is %d, out of range\n",tid);
-        return -1;
-    }
-   
-    BitMap *tidmap = _tidmap;
-    // printf("last tid is %d \n",last);    
-    if(!tidmap->NumClear()) {//No more clear bits
-	printf("No more clear bits!\n");
-	return -1;//I do not schedule threads now
+//----------------------------------------------------------------------
+// first_set
+// 	Return the index of the lowest bit set in "word", which must
+//	not be zero.
+//----------------------------------------------------------------------
+
+static int first_set(unsigned int word) {
+#ifdef __GNUC__
+    return __builtin_ctz(word);
+#else
+    int bit = 0;
+
+    while (!(word & 1)) {
+	word >>= 1;
+	bit++;
     }
-    int _return = find_next_zero_bit(tid);
-    //printf("return %d\n",_return);
-//    return find_next_zero_bit(tid);    
-    return _return;
+    return bit;
+#endif
 }
 
-void clear_bit(int tid) {
-    _tidmap->Clear(tid);
+//----------------------------------------------------------------------
+// bits_from
+// 	Return a mask of the bits in a word at or above "bit"; nothing
+//	if "bit" is past the end of the word.
+//----------------------------------------------------------------------
+
+static unsigned int bits_from(int bit) {
+    if (bit >= BITS_PER_WORD)
+	return 0;
+    return ~0U << bit;
+}
+
+//----------------------------------------------------------------------
+// init_tidmap
+// 	Mark every id as free.  Done on the first allocation, rather than
+//	by a constructor, so that it can't depend on the order in which
+//	static objects are initialized.
+//----------------------------------------------------------------------
+
+static void init_tidmap() {
+    struct tidmap *map = &_tidmap;
+    int i;
+
+    for (i = 0; i < TIDMAP_WORDS; i++)
+	map->page[i] = ~0U;
+    for (i = 0; i < TIDMAP_SUMMARY_WORDS; i++)
+	map->summary[i] = ~0U;
+    map->top = bits_from(0) & ~bits_from(TIDMAP_SUMMARY_WORDS);
+    map->nr_free = TID_MAX_DEFAULT;
+    tidmap_ready = TRUE;
 }
 
-int find_next_zero_bit(int tid) {
-    BitMap *tidmap = _tidmap;
-    int tid_max = TID_MAX_DEFAULT;
-    if(!tidmap->NumClear()) {
-        return -1;
+//----------------------------------------------------------------------
+// find_next_free
+// 	Return the first free id at or after "tid", or -1 if there is
+//	none before the end of the map.
+//----------------------------------------------------------------------
+
+static int find_next_free(int tid) {
+    struct tidmap *map = &_tidmap;
+    int w = tid / BITS_PER_WORD, s = w / BITS_PER_WORD;
+    unsigned int bits;
+
+    if (tid >= TID_MAX_DEFAULT)
+	return -1;
+    bits = map->page[w] & bits_from(tid % BITS_PER_WORD);
+    if (bits == 0) {				// nothing left in this word;
+	bits = map->summary[s] & bits_from(w % BITS_PER_WORD + 1);
+	if (bits == 0) {			// or the rest of its summary
+	    bits = map->top & bits_from(s + 1);
+	    if (bits == 0)
+		return -1;
+	    s = first_set(bits);
+	    bits = map->summary[s];
+	}
+	w = s * BITS_PER_WORD + first_set(bits);
+	bits = map->page[w];
     }
-    for(int i = tid,j = 0;i%tid_max < tid_max && j < tid_max; i++) {
-	
-    	if(!tidmap->Test(i)) {
-	    tidmap->Mark(i);
-            last_tid = i;
-            return i;
-        }
-	if(j == tid_max - 1){
-            break;
-        }
-	
+    return w * BITS_PER_WORD + first_set(bits);
+}
+
+//----------------------------------------------------------------------
+// alloc_tidmap
+// 	Mark the next free id after the last one allocated as in use,
+//	and return it; -1 if all TID_MAX_DEFAULT ids are in use.
+//----------------------------------------------------------------------
+
+int alloc_tidmap() {
+    struct tidmap *map = &_tidmap;
+    int tid, w, s;
+
+    if (!tidmap_ready)
+	init_tidmap();
+    if (map->nr_free == 0)
+	return -1;
+    tid = find_next_free(last_tid + 1);
+    if (tid < 0)				// wrap around
+	tid = find_next_free(0);
+    ASSERT(tid >= 0);
+
+    w = tid / BITS_PER_WORD;
+    s = w / BITS_PER_WORD;
+    map->page[w] &= ~(1U << (tid % BITS_PER_WORD));
+    if (map->page[w] == 0) {
+	map->summary[s] &= ~(1U << (w % BITS_PER_WORD));
+	if (map->summary[s] == 0)
+	    map->top &= ~(1U << s);
     }
-    return -1;
+    map->nr_free--;
+    last_tid = tid;
+    return tid;
+}
+
+//----------------------------------------------------------------------
+// free_tidmap
+// 	Mark "tid", returned by alloc_tidmap, as free again.
+//----------------------------------------------------------------------
+
+void free_tidmap(int tid) {
+    struct tidmap *map = &_tidmap;
+    int w = tid / BITS_PER_WORD, s = w / BITS_PER_WORD;
+
+    ASSERT(tidmap_ready && tid >= 0 && tid < TID_MAX_DEFAULT);
+    ASSERT(!(map->page[w] & (1U << (tid % BITS_PER_WORD))));
+    map->page[w] |= 1U << (tid % BITS_PER_WORD);
+    map->summary[s] |= 1U << (w % BITS_PER_WORD);
+    map->top |= 1U << s;
+    map->nr_free++;
 }
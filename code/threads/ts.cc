@@ -18,7 +18,7 @@ Ts::~Ts() {
 
 void Ts::PrintThreadInfo() {
 
-	printf("Tid\tUid\tThread Name\tStatus\t\tPriority\tSlices\n");
+	printf("Tid\tUid\tThread Name\tStatus\t\tPriority\tSlices\tVruntime\tSwitches\n");
 	//printf("%d\t%d\t%s\t\tRUNNING\n",currentThread->getTid(),currentThread->getUid(),currentThread->getName());
 	scheduler->Print();//print the content of readylist.
 }
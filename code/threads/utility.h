@@ -14,6 +14,7 @@
 //   	'd' -- disk emulation (FILESYS)
 //   	'f' -- file system (FILESYS)
 //   	'a' -- address spaces (USER_PROGRAM)
+//   	'j' -- translation of user code to host code (USER_PROGRAM)
 //   	'n' -- network emulation (NETWORK)
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
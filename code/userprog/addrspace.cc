@@ -18,11 +18,12 @@
 #include "copyright.h"
 #include "system.h"
 #include "addrspace.h"
-#include "noff.h"
 #ifdef HOST_SPARC
 #include <strings.h>
 #endif
 
+static int numSpaces = 0;		// address spaces created so far
+
 //----------------------------------------------------------------------
 // SwapHeader
 // 	Do little endian to big endian conversion on the bytes in the 
@@ -48,23 +49,28 @@ SwapHeader (NoffHeader *noffH)
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
 // 	Create an address space to run a user program.
-//	Load the program from a file "executable", and set everything
-//	up so that we can start executing user instructions.
+//	Read the header of the program in the file "executable", and
+//	set everything up so that we can start executing user instructions.
 //
 //	Assumes that the object code file is in NOFF format.
 //
-//	First, set up the translation from program memory to physical 
-//	memory.  For now, this is really simple (1:1), since we are
-//	only uniprogramming, and we have a single unsegmented page table
+//	Nothing is loaded yet: every page starts out invalid, and is
+//	given a frame, and loaded, the first time it is touched (see
+//	PageIn).  So starting a program costs in proportion to the pages
+//	it actually uses, not its size.  We keep the file open until
+//	then.
 //
-//	"executable" is the file containing the object code to load into memory
+//	"executableFile" is the file containing the object code to load
+//		into memory
 //----------------------------------------------------------------------
 
-AddrSpace::AddrSpace(OpenFile *executable)
+AddrSpace::AddrSpace(OpenFile *executableFile)
 {
-    NoffHeader noffH;
     unsigned int i, size;
 
+    executable = executableFile;
+    executableUsers = new int;
+    *executableUsers = 1;
     executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
     if ((noffH.noffMagic != NOFFMAGIC) && 
 		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
@@ -78,54 +84,384 @@ AddrSpace::AddrSpace(OpenFile *executable)
     numPages = divRoundUp(size, PageSize);
     size = numPages * PageSize;
 
+#ifndef VM
     ASSERT(numPages <= NumPhysPages);		// check we're not trying
 						// to run anything too big --
 						// at least until we have
 						// virtual memory
+#endif
 
-    DEBUG('a', "Initializing address space, num pages %d, size %d\n", 
-					numPages, size);
-// first, set up the translation 
+    id = ++numSpaces;
+    DEBUG('a', "Initializing address space %d, num pages %d, size %d\n", 
+					id, numPages, size);
+// first, set up the translation, with nothing in memory yet
     pageTable = new TranslationEntry[numPages];
+    copyOnWrite = new bool[numPages];
     for (i = 0; i < numPages; i++) {
-	pageTable[i].virtualPage = i;	// for now, virtual page # = phys page #
-	pageTable[i].physicalPage = i;
-	pageTable[i].valid = TRUE;
+	copyOnWrite[i] = FALSE;
+	pageTable[i].virtualPage = i;
+	pageTable[i].physicalPage = -1;
+	pageTable[i].valid = FALSE;
 	pageTable[i].use = FALSE;
 	pageTable[i].dirty = FALSE;
 	pageTable[i].readOnly = FALSE;  // if the code segment was entirely on 
 					// a separate page, we could set its 
 					// pages to be read-only
     }
-    
-// zero out the entire address space, to zero the unitialized data segment 
-// and the stack segment
-    bzero(machine->mainMemory, size);
-
-// then, copy in the code and data segments into memory
-    if (noffH.code.size > 0) {
-        DEBUG('a', "Initializing code segment, at 0x%x, size %d\n", 
-			noffH.code.virtualAddr, noffH.code.size);
-        executable->ReadAt(&(machine->mainMemory[noffH.code.virtualAddr]),
-			noffH.code.size, noffH.code.inFileAddr);
-    }
-    if (noffH.initData.size > 0) {
-        DEBUG('a', "Initializing data segment, at 0x%x, size %d\n", 
-			noffH.initData.virtualAddr, noffH.initData.size);
-        executable->ReadAt(&(machine->mainMemory[noffH.initData.virtualAddr]),
-			noffH.initData.size, noffH.initData.inFileAddr);
-    }
+    numResident = 0;
+#ifdef VM
+    swapSector = new int[numPages];
+    for (i = 0; i < numPages; i++)
+	swapSector[i] = -1;
+#endif
+#ifdef USE_TLB
+    asid = -1;				// until it first runs
+#endif
+}
 
+//----------------------------------------------------------------------
+// AddrSpace::AddrSpace
+// 	Create a copy of an address space, for Fork, copy-on-write: the
+//	child maps each page the parent has in memory to the same frame,
+//	and both map it read-only, so that whichever writes it first gets
+//	a copy of its own (see CopyOnWrite).  Pages not in memory are
+//	shared too: the child reads them from the parent's swap sectors,
+//	or from the executable, which it shares.  So a fork costs in
+//	proportion to the number of pages, not their contents, and only
+//	the pages written afterwards are ever copied.
+//
+//	"parent" is the address space to copy
+//----------------------------------------------------------------------
+
+AddrSpace::AddrSpace(AddrSpace *parent)
+{
+    TranslationEntry *entry;
+    unsigned int i;
+
+    numPages = parent->numPages;
+    numResident = parent->numResident;
+    executable = parent->executable;
+    executableUsers = parent->executableUsers;
+    (*executableUsers)++;
+    noffH = parent->noffH;
+    id = ++numSpaces;
+    DEBUG('a', "Forking address space %d from %d, %d frames shared\n", id,
+		parent->id, numResident);
+
+#ifdef VM
+    pager->Acquire();			// nothing may be evicted meanwhile
+    swapSector = new int[numPages];
+#endif
+    pageTable = new TranslationEntry[numPages];
+    copyOnWrite = new bool[numPages];
+    for (i = 0; i < numPages; i++) {
+	entry = &parent->pageTable[i];
+	if (entry->valid) {
+	    if (!entry->readOnly) {		// it is read-only from now on
+#ifdef USE_TLB
+		tlbManager->Invalidate(parent, i);
+#endif
+		entry->readOnly = TRUE;
+		parent->copyOnWrite[i] = TRUE;
+	    }
+	    frameTable->Share(entry->physicalPage, this);
+	}
+	pageTable[i] = *entry;
+	copyOnWrite[i] = parent->copyOnWrite[i];
+#ifdef VM
+	swapSector[i] = parent->swapSector[i];
+	if (swapSector[i] >= 0)
+	    pager->ShareSwap(swapSector[i]);
+#endif
+    }
+    machine->FlushSoftTLB();		// the parent's pages may be cached
+					// as writable
+#ifdef VM
+    pager->Release();
+#endif
+#ifdef USE_TLB
+    asid = -1;				// until it first runs
+#endif
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.  Nothing for now!
+// 	Dealloate an address space, giving its frames back to the
+//	frame table, and its swap sectors back to the pager, and close
+//	the executable, unless a forked copy is still using it.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
 {
-   delete pageTable;
+    unsigned int i;
+
+    DEBUG('a', "Deleting address space %d, %d frames resident\n", id,
+		numResident);
+#ifdef VM
+    pager->Acquire();			// not while one of our pages is
+					// being evicted
+    for (i = 0; i < numPages; i++)
+	if (swapSector[i] >= 0)
+	    pager->FreeSwap(swapSector[i]);
+    delete [] swapSector;
+#endif
+#ifdef USE_TLB
+    tlbManager->Forget(this);
+#endif
+    for (i = 0; i < numPages; i++)
+	if (pageTable[i].valid)
+	    frameTable->Free(pageTable[i].physicalPage, this);
+#ifdef VM
+    pager->Release();
+#endif
+    delete [] pageTable;
+    delete [] copyOnWrite;
+    if (--(*executableUsers) == 0) {
+	delete executable;
+	delete executableUsers;
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PageIn
+// 	Bring a page into memory, because the program touched it: give
+//	it a frame, and fill the frame from swap, if the page has been
+//	written out there, or else from whichever of the code and
+//	initialized data segments overlap the page, and with zeroes
+//	everywhere else (uninitialized data and stack).
+//
+//	With virtual memory, the pager finds the frame, evicting some
+//	other page if memory is full, and we hold its lock throughout.
+//
+//	"virtualPage" is the page, which must not be in memory already
+//----------------------------------------------------------------------
+
+void
+AddrSpace::PageIn(int virtualPage)
+{
+    int frame;
+
+    ASSERT(virtualPage >= 0 && virtualPage < (int) numPages);
+#ifdef VM
+    pager->Acquire();
+    if (pageTable[virtualPage].valid) {	// brought in while we waited
+	pager->Release();
+	return;
+    }
+    frame = pager->FindFrame(this, virtualPage);
+#else
+    ASSERT(!pageTable[virtualPage].valid);
+
+    frame = frameTable->Alloc(this, virtualPage);
+    ASSERT(frame >= 0);			// physical memory is full --
+					// at least until we have
+					// virtual memory
+#endif
+    DEBUG('a', "Paging in page %d of address space %d, to frame %d\n",
+		virtualPage, id, frame);
+    stats->numPageFaults++;
+
+    pageTable[virtualPage].physicalPage = frame;
+#ifdef VM
+    if (swapSector[virtualPage] >= 0)
+	pager->ReadSwap(swapSector[virtualPage], frame);
+    else
+#endif
+    {
+	bzero(&machine->mainMemory[frame * PageSize], PageSize);
+	LoadSegment(&noffH.code, virtualPage);
+	LoadSegment(&noffH.initData, virtualPage);
+    }
+
+    pageTable[virtualPage].valid = TRUE;
+    pageTable[virtualPage].readOnly = FALSE;	// the frame is ours alone
+    copyOnWrite[virtualPage] = FALSE;
+    pageTable[virtualPage].use = FALSE;
+    pageTable[virtualPage].dirty = FALSE;
+    numResident++;
+#ifdef VM
+    pager->Loaded(frame);
+    pager->Release();
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyOnWrite
+// 	The program wrote to a page it shares with a forked copy of
+//	itself (or the kernel did, for it): give it a frame of its own,
+//	with a copy of the page, and let it write there.  If nobody else
+//	has the frame any more, it can just have it.
+//
+//	The page is copied out of the frame before we look for a new one,
+//	and we give up our share of the old one meanwhile, so that if the
+//	pager evicts the old frame to find the new one, that's all right.
+//
+//	"virtualPage" is the page written to
+//----------------------------------------------------------------------
+
+void
+AddrSpace::CopyOnWrite(int virtualPage)
+{
+    TranslationEntry *entry;
+    char copy[PageSize];
+    int frame;
+
+    ASSERT(virtualPage >= 0 && virtualPage < (int) numPages);
+    entry = &pageTable[virtualPage];
+#ifdef VM
+    pager->Acquire();
+#endif
+    if (!entry->valid || !entry->readOnly) { // evicted, or copied, while
+#ifdef VM					// we waited for the pager
+	pager->Release();
+#endif
+	return;
+    }
+    ASSERT(copyOnWrite[virtualPage]);	// no page is really read-only
+#ifdef USE_TLB
+    tlbManager->Invalidate(this, virtualPage);
+#endif
+
+    frame = entry->physicalPage;
+    if (frameTable->NumSharers(frame) > 1) {
+	DEBUG('a', "Copying page %d of address space %d, from frame %d\n",
+		virtualPage, id, frame);
+	bcopy(&machine->mainMemory[frame * PageSize], copy, PageSize);
+	entry->valid = FALSE;
+	frameTable->Free(frame, this);
+#ifdef VM
+	frame = pager->FindFrame(this, virtualPage);
+#else
+	frame = frameTable->Alloc(this, virtualPage);
+	ASSERT(frame >= 0);		// physical memory is full
+#endif
+	bcopy(copy, &machine->mainMemory[frame * PageSize], PageSize);
+	entry->physicalPage = frame;
+	entry->valid = TRUE;
+	stats->numPageCopies++;
+#ifdef VM
+	pager->Loaded(frame);
+#endif
+    }
+    entry->readOnly = FALSE;
+    copyOnWrite[virtualPage] = FALSE;
+    machine->FlushSoftTLB();		// it may have been cached read-only
+#ifdef VM
+    pager->Release();
+#endif
+}
+
+#ifdef VM
+//----------------------------------------------------------------------
+// AddrSpace::PageOut
+// 	Evict a page from memory, because the pager wants its frame.  If
+//	the page has been changed since it was brought in, write it to
+//	swap (giving it a swap sector, the first time); if not, it can be
+//	brought in again from where it came from.  Called with the
+//	pager's lock held.
+//
+//	If the frame is shared since a Fork, it is evicted from every
+//	address space that has it: it is written to a new swap sector,
+//	dirty or not, which they all share from then on.  A dirty page
+//	whose swap sector is shared is written to a new sector too,
+//	rather than over what the others still need.
+//
+//	The page is marked invalid first, so that if we have to wait
+//	for the disk, and its program runs meanwhile and touches it, it
+//	faults, and waits for the lock.
+//
+//	"virtualPage" is the page, which must be in memory
+//----------------------------------------------------------------------
+
+void
+AddrSpace::PageOut(int virtualPage)
+{
+    TranslationEntry *entry = &pageTable[virtualPage];
+    int frame = entry->physicalPage;
+    int sector = swapSector[virtualPage];
+    bool shared = (frameTable->NumSharers(frame) > 1);
+    bool newSector = FALSE;
+    ListElement *sharer;
+    AddrSpace *space;
+
+    ASSERT(entry->valid);
+    for (sharer = frameTable->Sharers(frame); sharer != NULL;
+						sharer = sharer->next) {
+	space = (AddrSpace *) sharer->item;
+#ifdef USE_TLB
+	tlbManager->Invalidate(space, virtualPage);	// for its dirty bit
+#endif
+	space->pageTable[virtualPage].valid = FALSE;
+    }
+    machine->FlushSoftTLB();		// it may have been cached
+    DEBUG('a', "Paging out page %d of address space %d, from frame %d%s%s\n",
+		virtualPage, id, frame, entry->dirty ? ", dirty" : "",
+		shared ? ", shared" : "");
+
+    if (shared || entry->dirty) {
+	if (shared || sector < 0 || pager->SwapSharers(sector) > 1) {
+	    sector = pager->AllocSwap();
+	    newSector = TRUE;
+	}
+	pager->WriteSwap(sector, frame);
+    }
+    while ((space = frameTable->Owner(frame)) != NULL) {
+	if (newSector) {
+	    if (space->swapSector[virtualPage] >= 0)
+		pager->FreeSwap(space->swapSector[virtualPage]);
+	    space->swapSector[virtualPage] = sector;
+	    pager->ShareSwap(sector);
+	}
+	space->pageTable[virtualPage].physicalPage = -1;
+	space->pageTable[virtualPage].dirty = FALSE;
+	space->numResident--;
+	frameTable->Free(frame, space);
+    }
+    if (newSector)
+	pager->FreeSwap(sector);	// AllocSwap's share of it
+}
+#endif
+
+//----------------------------------------------------------------------
+// AddrSpace::LoadSegment
+// 	Copy the part of a segment of the executable that is on a page
+//	(if any) into the page's frame.
+//
+//	"segment" is the segment, from the NOFF header
+//	"virtualPage" is the page, which has been given a frame
+//----------------------------------------------------------------------
+
+void
+AddrSpace::LoadSegment(Segment *segment, int virtualPage)
+{
+    int start = virtualPage * PageSize;		// the page's addresses
+    int end = start + PageSize;
+
+    if (segment->size <= 0)
+	return;
+    if (segment->virtualAddr > start)		// the part of them in
+	start = segment->virtualAddr;		// the segment
+    if (segment->virtualAddr + segment->size < end)
+	end = segment->virtualAddr + segment->size;
+    if (start >= end)
+	return;
+    executable->ReadAt(&(machine->mainMemory[
+		pageTable[virtualPage].physicalPage * PageSize
+		+ start % PageSize]),
+	end - start, segment->inFileAddr + (start - segment->virtualAddr));
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Print
+// 	Print the size of the address space, and how much of it is
+//	resident in physical memory.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Print()
+{
+    printf("Address space %d: %d pages, %d frames resident\n", id, numPages,
+		numResident);
 }
 
 //----------------------------------------------------------------------
@@ -165,7 +501,8 @@ AddrSpace::InitRegisters()
 // 	On a context switch, save any machine state, specific
 //	to this address space, that needs saving.
 //
-//	For now, nothing!
+//	For now, nothing!  With a TLB, its entries are tagged with our
+//	address space id, so they can stay.
 //----------------------------------------------------------------------
 
 void AddrSpace::SaveState() 
@@ -176,11 +513,21 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table, and
+//	drop any translations it cached, and instructions it pre-decoded,
+//	under the old one.  With a TLB, just tell it our address space
+//	id instead; our entries are still there, if nobody has replaced
+//	them.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() 
 {
+#ifdef USE_TLB
+    tlbManager->Switch(this);
+#else
     machine->pageTable = pageTable;
     machine->pageTableSize = numPages;
+    machine->FlushSoftTLB();
+#endif
+    machine->FlushDecodeCache();
 }
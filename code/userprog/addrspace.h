@@ -2,9 +2,19 @@
 //	Data structures to keep track of executing user programs 
 //	(address spaces).
 //
-//	For now, we don't keep any information about address spaces.
-//	The user level CPU state is saved and restored in the thread
-//	executing the user program (see thread.h).
+//	Each address space has its own page table, mapping its pages to
+//	the physical page frames it has been given (see frametable.h),
+//	so several can be in memory at once.  Pages are loaded on
+//	demand: none is in memory until the program touches it, and
+//	the page fault handler calls PageIn.  With virtual memory (VM),
+//	the pager may take a page's frame back when memory is full (see
+//	PageOut), and the page is brought in again from swap on its next
+//	fault.  A Fork copies an address space copy-on-write: the child
+//	shares the parent's frames, read-only, and whichever of them
+//	first writes a page gets a copy of it (see CopyOnWrite).  The
+//	user level CPU state
+//	is saved and restored in the thread executing the user program
+//	(see thread.h).
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -15,6 +25,7 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "noff.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
 
@@ -23,6 +34,10 @@ class AddrSpace {
     AddrSpace(OpenFile *executable);	// Create an address space,
 					// initializing it with the program
 					// stored in the file "executable"
+					// (which it now owns, and closes)
+    AddrSpace(AddrSpace *parent);	// Create a copy of "parent", for
+					// Fork, sharing its pages until
+					// either writes them
     ~AddrSpace();			// De-allocate an address space
 
     void InitRegisters();		// Initialize user-level CPU registers,
@@ -31,11 +46,53 @@ class AddrSpace {
     void SaveState();			// Save/restore address space-specific
     void RestoreState();		// info on a context switch 
 
+    void PageIn(int virtualPage);	// bring a page into memory, on a
+					// page fault
+    void CopyOnWrite(int virtualPage);	// give a shared page a frame of
+					// its own, on a write to it
+
+#ifdef VM
+    void PageOut(int virtualPage);	// evict a page, to swap if it has
+					// been changed; the pager's choice
+#endif
+    TranslationEntry *GetEntry(int virtualPage)
+	{ return &pageTable[virtualPage]; }
+#ifdef USE_TLB
+    int GetAsid() { return asid; }	// its TLB address space id,
+    void SetAsid(int newAsid)		// or -1 if it has none
+	{ asid = newAsid; }
+#endif
+
+    int GetId() { return id; }		// its SpaceId, for Fork
+    int NumPages() { return numPages; }
+    int NumResident() { return numResident; } // frames it has in memory
+    void Print();			// print its size and resident frames
+
   private:
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    int numResident;			// pages in memory, in frames of
+					// their own or shared
+    int id;				// to tell address spaces apart
+    OpenFile *executable;		// where the pages come from
+    int *executableUsers;		// address spaces sharing it, since
+					// a Fork; the last one closes it
+    NoffHeader noffH;			// and where in it they are
+    bool *copyOnWrite;			// is the page read-only only because
+					// it is shared since a Fork?
+#ifdef VM
+    int *swapSector;			// where each page is kept in swap;
+					// -1 if it has never been written out
+#endif
+#ifdef USE_TLB
+    int asid;				// its TLB entries' address space id
+#endif
+
+    void LoadSegment(Segment *segment, int virtualPage);
+					// copy the part of "segment" that is
+					// on "virtualPage" into its frame
 };
 
 #endif // ADDRSPACE_H
@@ -14,8 +14,12 @@
 //	Interrupts (which can also cause control to transfer from user
 //	code into the Nachos kernel) are handled elsewhere.
 //
-// For now, this only handles the Halt() system call.
-// Everything else core dumps.
+// Page faults are handled by loading the page (see AddrSpace::PageIn).
+// With a TLB, a page fault is usually just a TLB miss, and we refill the
+// TLB from the page table (see TLBManager::Refill) and return at once.
+// A read-only exception is a write to a page shared copy-on-write since
+// a Fork, and gets the program a copy of the page (AddrSpace::CopyOnWrite).
+// Anything else unexpected core dumps.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -27,6 +31,46 @@
 #include "openfile.h"
 #include "string.h"
 
+#define MaxStringArg	256	// longest string argument (a file name, or
+				// text to print) we accept, with its null
+
+//----------------------------------------------------------------------
+// AdvancePC
+// 	Move the user program's PC past the system call it just made,
+//	so that it continues with the next instruction when we return.
+//----------------------------------------------------------------------
+
+static void
+AdvancePC()
+{
+	int pc = machine->ReadRegister(NextPCReg);
+
+	machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
+	machine->WriteRegister(PCReg, pc);
+	machine->WriteRegister(NextPCReg, pc + 4);
+}
+
+//----------------------------------------------------------------------
+// ForkedProcess
+// 	Start the child of a Fork system call running: it returns from
+//	the call, as the parent does, but with 0 rather than its own
+//	address space identifier.
+//
+//	"arg" is unused
+//----------------------------------------------------------------------
+
+static void
+ForkedProcess(int arg)
+{
+	currentThread->RestoreUserState();	// as the parent had them,
+	machine->WriteRegister(2, 0);		// when it made the call
+	AdvancePC();
+	currentThread->space->RestoreState();
+
+	machine->Run();			// back to the user program
+	ASSERT(FALSE);			// machine->Run never returns
+}
+
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -44,7 +88,11 @@
 //	The result of the system call, if any, must be put back into r2. 
 //
 // And don't forget to increment the pc before returning. (Or else you'll
-// loop making the same system call forever!
+// loop making the same system call forever!  AdvancePC does it.)
+//
+// String and buffer arguments are copied in and out of user memory with
+// Machine::CopyFromUser, CopyToUser and CopyStringFromUser, a page at a
+// time, rather than a byte at a time with ReadMem and WriteMem.
 //
 //	"which" is the kind of exception.  The list of possible exceptions 
 //	are in machine.h.
@@ -63,60 +111,36 @@ ExceptionHandler(ExceptionType which)
 
 		} else if (type == SC_Create) {
 			DEBUG('a', "Create a new file.\n");
-			int baseAddr = machine->ReadRegister(4);
-			int value = -1;
-			char *name;
+			char name[MaxStringArg];
+			int length = machine->CopyStringFromUser(
+				machine->ReadRegister(4), name, MaxStringArg);
 
-			int size = 0;
-			while(value != 0) {
-				machine->ReadMem(baseAddr + size, 1,&value);
-				size++;
-			}
-			name = new char[size];
-			name[--size] = '\0';
-			int counter = 0;
-			while(size--) {
-				machine->ReadMem(baseAddr++,1,&value);
-				name[counter++] = (char)value;
-			}
-			printf("Exception: First arg is %s. Arg's length is %d\n",name,counter + 1);
-			if(!fileSystem->Create(name, DT_NORMAL)) {
-				printf("Exception: Create file failed.\n");
+			if (length < 0) {
+				printf("Exception: Bad file name.\n");
+			} else {
+				printf("Exception: First arg is %s. Arg's length is %d\n",name,length + 1);
+				if(!fileSystem->Create(name, DT_NORMAL)) {
+					printf("Exception: Create file failed.\n");
+				}
 			}
-			delete name;
 
 		} else if (type == SC_Open) {
 			DEBUG('a', "Open a file. Return 0 if failed.\n");
-			int baseAddr = machine->ReadRegister(4);
-			int value = -1;
-			char *name;
+			char name[MaxStringArg];
+			OpenFile* file = NULL;
+			OpenFileId fd = 0;
 
-			int size = 0;
-			while(value != 0) {
-				machine->ReadMem(baseAddr + size, 1,&value);
-				size++;
-			}
-			name = new char[size];
-			name[--size] = '\0';
-			int counter = 0;
-			while(size--) {
-				machine->ReadMem(baseAddr++,1,&value);
-				name[counter++] = (char)value;
-			}
-			OpenFile* file = fileSystem->Open(name);
-			//			OpenFileId fd = (int)file;
-			OpenFileId fd = file->GetFileDescriptor();
+			if (machine->CopyStringFromUser(machine->ReadRegister(4),
+						name, MaxStringArg) >= 0)
+				file = fileSystem->Open(name);
+			if (file != NULL) {
+				fd = file->GetFileDescriptor();
 #ifdef FILESYS_STUB
 #else//FILESYS
-			fileSystem->AddToTable(fd,file);
+				fileSystem->AddToTable(fd,file);
 #endif
-			//			if(file) {
-			//				fd = (int)file;
-			//			} else {
-			//				fd = -1;
-			//			}
+			}
 			machine->WriteRegister(2,fd);
-			delete name;
 
 		} else if (type == SC_Close) {
 			DEBUG('a', "Close a file specified by id.\n");
@@ -137,99 +161,145 @@ ExceptionHandler(ExceptionType which)
 			int fd = machine->ReadRegister(6);
 			int size = machine->ReadRegister(5);
 			int baseAddr = machine->ReadRegister(4);
-			char* buffer = new char[size];
-			//			int value = -1;
-			int i = 0;
-			while(i < size) {
-				machine->ReadMem(baseAddr + i, 1,(int *)&buffer[i]);
-				i++;
-			}
+
+			if (size < 0) {
+				printf("Exception: Bad size for write.\n");
+			} else {
+				char* buffer = new char[size];
+				if (!machine->CopyFromUser(baseAddr, buffer, size)) {
+					printf("Exception: Bad buffer for write.\n");
+				} else {
 #ifdef FILESYS_STUB
-			OpenFile* file = new OpenFile(fd);
+					OpenFile* file = new OpenFile(fd);
 #else//FILESYS
-			OpenFile* file = fileSystem->GetFromTable(fd);
+					OpenFile* file = fileSystem->GetFromTable(fd);
 #endif
-			int realSize = file->Write(buffer,size);
-			if(realSize != size) {
-				printf("Exception: Only wrote %d bytes of size.\n",realSize,size);
-			} else {
-				printf("Exception: Write %d bytes successfully\n",realSize);
+					int realSize = file->Write(buffer,size);
+					if(realSize != size) {
+						printf("Exception: Only wrote %d bytes of %d.\n",realSize,size);
+					} else {
+						printf("Exception: Write %d bytes successfully\n",realSize);
+					}
+				}
+				delete [] buffer;
 			}
-			delete buffer;
 
 		} else if (type == SC_Read) {
 			DEBUG('a', "Read a file.\n");
 			int fd = machine->ReadRegister(6);
 			int size = machine->ReadRegister(5);
 			int baseAddr = machine->ReadRegister(4);
-			char* buffer = new char[size];
+			int realSize = -1;
+
+			if (size >= 0) {
+				char* buffer = new char[size];
 #ifdef FILESYS_STUB
-			OpenFile* file = new OpenFile(fd);
+				OpenFile* file = new OpenFile(fd);
 #else//FILESYS
-			OpenFile* file = fileSystem->GetFromTable(fd);
+				OpenFile* file = fileSystem->GetFromTable(fd);
 #endif
-			//			file->Seek(0);
-			int realSize = file->Read(buffer,size);
-			int i = 0;
-			while(i < size) {
-				machine->WriteMem(baseAddr + i, 1,(int)buffer);
-				i++;
+				//			file->Seek(0);
+				realSize = file->Read(buffer,size);
+				if (!machine->CopyToUser(baseAddr, buffer, realSize)) {
+					printf("Exception: Bad buffer for read.\n");
+					realSize = -1;
+				} else if(realSize != size) {
+					printf("Exception: Only read %d bytes of %d.\n",realSize,size);
+				} else {
+					printf("Exception: Read %d bytes successfully\n",realSize);
+				}
+				delete [] buffer;
 			}
-			if(realSize != size) {
-				printf("Exception: Only wrote %d bytes of size.\n",realSize,size);
-			} else {
-				machine->WriteRegister(2, realSize);
-				printf("Exception: Read %d bytes successfully\n",realSize);
-			}
-			delete buffer;
+			machine->WriteRegister(2, realSize);
+
 		} else if (type == SC_Print) {//Print somethine...
 			DEBUG('a', "Print a string within a integer.\n");
-			int baseAddr = machine->ReadRegister(4);
+			char content[MaxStringArg];
 			int arg2 = machine->ReadRegister(5);
-			int value = -1;
-			char *content;
-			int size = 0;
-			while(value != 0) {
-				machine->ReadMem(baseAddr + size, 1,&value);
-				size++;
-			}
-			content = new char[size];
-			content[--size] = '\0';
-			int counter = 0;
-			while(size--) {
-				machine->ReadMem(baseAddr++,1,&value);
-				content[counter++] = (char)value;
-			}
-			printf(content,arg2);
-			delete content;
+
+			if (machine->CopyStringFromUser(machine->ReadRegister(4),
+						content, MaxStringArg) >= 0)
+				printf(content,arg2);
+
 		} else if (type == SC_Mkdir) {
 			DEBUG('a', "Make a directory specified by path.\n");
-			int baseAddr = machine->ReadRegister(4);
-			int value = -1;
-			char *name;
+			char name[MaxStringArg];
 
-			int size = 0;
-			while(value != 0) {
-				machine->ReadMem(baseAddr + size, 1,&value);
-				size++;
-			}
-			name = new char[size];
-			name[--size] = '\0';
-			int counter = 0;
-			while(size--) {
-				machine->ReadMem(baseAddr++,1,&value);
-				name[counter++] = (char)value;
-			}
-			if(!fileSystem->Create(name,DT_DIR)) {
+			if (machine->CopyStringFromUser(machine->ReadRegister(4),
+						name, MaxStringArg) < 0) {
+				printf("Exception: Bad directory name.\n");
+			} else if(!fileSystem->Create(name,DT_DIR)) {
 				printf("Exception: Create directory %s failed.\n",name);
 			} else {
 				printf("Exception: Directory %s created successfully.\n",name);
 			}
-			delete name;
+
+		} else if (type == SC_Sleep) {
+			DEBUG('a', "Sleep for %d ticks.\n", machine->ReadRegister(4));
+			currentThread->SleepFor(machine->ReadRegister(4));
+
+		} else if (type == SC_Fork) {
+			DEBUG('a', "Fork the address space.\n");
+			AddrSpace *space = new AddrSpace(currentThread->space);
+			Thread *child = new Thread("forked");
+			IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+			child->space = space;
+			child->SaveUserState();		// a copy of our registers
+			scheduler->ChargeRunningThread(); // and of how we are
+			child->setPriority(currentThread->getBasePriority());
+			child->setSchedLevel(currentThread->getSchedLevel());
+			child->setVruntime(currentThread->getVruntime());
+			(void) interrupt->SetLevel(oldLevel);	// scheduled
+			child->Fork(ForkedProcess, 0);
+			machine->WriteRegister(2, space->GetId());
+
+		} else if (type == SC_Yield) {
+			DEBUG('a', "Yield the CPU.\n");
+			currentThread->Yield();
+
+		} else if (type == SC_Exit) {
+			DEBUG('a', "Exit, with status %d.\n", machine->ReadRegister(4));
+			AddrSpace *space = currentThread->space;
+
+			currentThread->space = NULL;	// nothing to save any more
+			delete space;
+			currentThread->Finish();
+
 		}else {
 			printf("Exception: Unexpected exception type %d\n", type);
 			ASSERT(FALSE);
 		}
+		AdvancePC();
+
+	} else if (which == PageFaultException) {
+		int badVAddr = machine->ReadRegister(BadVAddrReg);
+
+		DEBUG('a', "Page fault at 0x%x.\n", badVAddr);
+#ifdef USE_TLB
+		if (tlbManager->Refill(badVAddr))
+			return;		// just a TLB miss: the page is in
+		if ((unsigned) badVAddr / PageSize
+			>= (unsigned) currentThread->space->NumPages()) {
+			printf("Exception: Address error at 0x%x\n", badVAddr);
+			ASSERT(FALSE);	// as without a TLB
+		}
+#endif
+		currentThread->space->PageIn(badVAddr / PageSize);
+#ifdef USE_TLB
+		(void) tlbManager->Refill(badVAddr); // saves a second miss
+#endif
+		// and the faulting instruction runs again
+
+	} else if (which == ReadOnlyException) {
+		int badVAddr = machine->ReadRegister(BadVAddrReg);
+
+		DEBUG('a', "Write to read-only page at 0x%x.\n", badVAddr);
+		currentThread->space->CopyOnWrite(badVAddr / PageSize);
+#ifdef USE_TLB
+		(void) tlbManager->Refill(badVAddr);
+#endif
+		// and the faulting instruction runs again
 
 	} else {
 		printf("Exception: Unexpected mode %d\n", which);
@@ -0,0 +1,180 @@
+// frametable.cc
+//	Routines to allocate physical page frames to address spaces.
+//
+//	The contents of a frame handed out are whatever its last owner
+//	left there; the new owner zeroes or loads it.  Since that is
+//	done behind the simulated CPU's back, any instructions the
+//	simulator pre-decoded from the frame are forgotten here.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "frametable.h"
+#include "system.h"
+#include "addrspace.h"
+
+//----------------------------------------------------------------------
+// FrameTable::FrameTable
+// 	Initialize the frame table, with every frame free.
+//
+//	"nframes" is the number of frames of physical memory
+//----------------------------------------------------------------------
+
+FrameTable::FrameTable(int nframes)
+{
+    int i;
+
+    numFrames = nframes;
+    freeMap = new BitMap(nframes);
+    frames = new FrameInfo[nframes];
+    for (i = 0; i < nframes; i++) {
+	frames[i].sharers = new List;
+	frames[i].numSharers = 0;
+	frames[i].virtualPage = -1;
+    }
+}
+
+//----------------------------------------------------------------------
+// FrameTable::~FrameTable
+// 	De-allocate the frame table.
+//----------------------------------------------------------------------
+
+FrameTable::~FrameTable()
+{
+    int i;
+
+    for (i = 0; i < numFrames; i++)
+	delete frames[i].sharers;
+    delete freeMap;
+    delete [] frames;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Alloc
+// 	Find a free frame, and give it to an address space.
+//
+//	Returns the frame number, or -1 if memory is full.
+//
+//	"space" is the address space to give it to
+//	"virtualPage" is the page of "space" it is to hold
+//----------------------------------------------------------------------
+
+int
+FrameTable::Alloc(AddrSpace *space, int virtualPage)
+{
+    int frame = freeMap->Find();
+
+    if (frame < 0)
+	return -1;
+    frames[frame].sharers->Append(space);
+    frames[frame].numSharers = 1;
+    frames[frame].virtualPage = virtualPage;
+    machine->InvalidateDecodeCache(frame);
+    DEBUG('a', "Frame %d allocated for virtual page %d\n", frame, virtualPage);
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Share
+// 	Give a frame that is in use to another address space as well, to
+//	map the same virtual page to, copy-on-write.
+//
+//	"frame" is the frame number, from Alloc
+//	"space" is the address space to give it to
+//----------------------------------------------------------------------
+
+void
+FrameTable::Share(int frame, AddrSpace *space)
+{
+    ASSERT(frame >= 0 && frame < numFrames && freeMap->Test(frame));
+    frames[frame].sharers->Append(space);
+    frames[frame].numSharers++;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Free
+// 	An address space gives a frame back.  Once no address space has
+//	it, it is free for some other address space to use.
+//
+//	"frame" is the frame number, from Alloc
+//	"space" is the address space giving it back
+//----------------------------------------------------------------------
+
+void
+FrameTable::Free(int frame, AddrSpace *space)
+{
+    bool found;
+
+    ASSERT(frame >= 0 && frame < numFrames && freeMap->Test(frame));
+    found = frames[frame].sharers->RemoveItem(space);
+    ASSERT(found);
+    if (--frames[frame].numSharers > 0)
+	return;
+    freeMap->Clear(frame);
+    frames[frame].virtualPage = -1;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Owner
+// 	Return the address space that brought the page in a frame into
+//	memory -- or, if it has since given the frame back, the first of
+//	those it was shared with.
+//
+//	"frame" is the frame number
+//----------------------------------------------------------------------
+
+AddrSpace *
+FrameTable::Owner(int frame)
+{
+    ListElement *first = frames[frame].sharers->Front();
+
+    if (first == NULL)
+	return NULL;
+    return (AddrSpace *) first->item;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Print
+// 	Print how much of physical memory is in use, and how many frames
+//	each address space has resident.  Each address space is printed
+//	at its first frame.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Print()
+{
+    int i, j;
+    ListElement *sharer;
+    AddrSpace *space;
+
+    printf("Frames: %d of %d in use\n", numFrames - NumFree(), numFrames);
+    for (i = 0; i < numFrames; i++)
+	for (sharer = Sharers(i); sharer != NULL; sharer = sharer->next) {
+	    space = (AddrSpace *) sharer->item;
+	    for (j = 0; j < i && !Holds(j, space); j++)
+		;
+	    if (j == i)
+		space->Print();
+	}
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Holds
+// 	Return TRUE if an address space has a frame (perhaps shared).
+//
+//	"frame" is the frame number
+//	"space" is the address space
+//----------------------------------------------------------------------
+
+bool
+FrameTable::Holds(int frame, AddrSpace *space)
+{
+    ListElement *sharer;
+
+    for (sharer = Sharers(frame); sharer != NULL; sharer = sharer->next)
+	if (sharer->item == space)
+	    return TRUE;
+    return FALSE;
+}
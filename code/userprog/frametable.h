@@ -0,0 +1,71 @@
+// frametable.h
+//	Data structures for allocating the page frames of physical
+//	memory to address spaces.
+//
+//	A bitmap records which frames are in use, and for each frame in
+//	use, we remember the address space and virtual page it holds, so
+//	that several programs can be resident in memory at once, each
+//	with its own page table, and so that we can tell who is using
+//	how much of memory.
+//
+//	After a Fork, parent and child share their frames, copy-on-write
+//	(see AddrSpace::CopyOnWrite), so a frame may belong to several
+//	address spaces -- always as the same virtual page.  It is counted
+//	as in use until the last of them frees it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "bitmap.h"
+#include "list.h"
+
+class AddrSpace;
+
+// What is in a physical page frame that is in use.
+
+class FrameInfo {
+  public:
+    List *sharers;		// the address spaces it belongs to, first
+				// the one that brought the page in
+    int numSharers;		// how many there are
+    int virtualPage;		// and the page it holds there
+};
+
+// The following class defines the table of physical page frames.
+
+class FrameTable {
+  public:
+    FrameTable(int nframes);		// initialize, with every frame free
+    ~FrameTable();
+
+    int Alloc(AddrSpace *space, int virtualPage); // a free frame, now
+					// holding "virtualPage" of "space";
+					// -1 if there are none
+    void Share(int frame, AddrSpace *space); // "space" has "frame" too
+    void Free(int frame, AddrSpace *space); // "space" gives "frame" back
+    int NumFree() { return freeMap->NumClear(); }
+
+    AddrSpace *Owner(int frame);	// the first address space with
+					// "frame"; NULL if it is free
+    ListElement *Sharers(int frame) { return frames[frame].sharers->Front(); }
+    int NumSharers(int frame) { return frames[frame].numSharers; }
+    int VirtualPage(int frame) { return frames[frame].virtualPage; }
+
+    void Print();			// print how many frames each
+					// address space has
+
+  private:
+    int numFrames;			// frames of physical memory
+    BitMap *freeMap;			// bit set if the frame is in use
+    FrameInfo *frames;			// what is in each frame
+
+    bool Holds(int frame, AddrSpace *space); // does "space" have "frame"?
+};
+
+#endif // FRAMETABLE_H
@@ -31,10 +31,8 @@ StartProcess(char *filename)
 		printf("Unable to open file %s\n", filename);
 		return;
 	}
-	space = new AddrSpace(executable);
-	currentThread->space = space;
-
-	delete executable;			// close file
+	space = new AddrSpace(executable);	// which closes the file
+	currentThread->space = space;		// when it's done with it
 
 	space->InitRegisters();		// set the initial register values
 	space->RestoreState();		// load page table register
@@ -45,6 +43,70 @@ StartProcess(char *filename)
 	// by doing the syscall "exit"
 }
 
+//----------------------------------------------------------------------
+// ForkBenchmark
+// 	Measure how long it takes to fork an address space, copy-on-write,
+//	against how many of its pages are in memory, and compare it with
+//	copying those pages, as a fork that copied eagerly would.  The
+//	pages not in memory cost a fork next to nothing, either way.
+//
+//	For each size, a fresh address space for the program is loaded
+//	with that many pages, and forked a number of times, deleting each
+//	copy again; the times are host time, per fork.
+//
+//	"filename" is the Nachos file holding the program
+//----------------------------------------------------------------------
+
+#define NumForks	100
+
+void
+ForkBenchmark(char *filename)
+{
+	static char copy[NumPhysPages * PageSize];
+	OpenFile *executable;
+	AddrSpace *space, *child;
+	int numPages, resident, i, j;
+	double start, forkTime, copyTime;
+
+	for (resident = 0; ; resident = (resident == 0) ? 1 : resident * 2) {
+		executable = fileSystem->Open(filename);
+		if (executable == NULL) {
+			printf("Unable to open file %s\n", filename);
+			return;
+		}
+		space = new AddrSpace(executable);
+		numPages = space->NumPages();
+		if (numPages > NumPhysPages)
+			numPages = NumPhysPages;
+		if (resident > numPages) {
+			delete space;
+			break;
+		}
+		for (i = 0; i < resident; i++)
+			space->PageIn(i);
+
+		start = HostTime();
+		for (i = 0; i < NumForks; i++) {
+			child = new AddrSpace(space);
+			delete child;
+		}
+		forkTime = (HostTime() - start) * 1e6 / NumForks;
+
+		start = HostTime();
+		for (i = 0; i < NumForks; i++)
+			for (j = 0; j < resident; j++)
+				memcpy(&copy[j * PageSize], &machine->mainMemory[
+				    space->GetEntry(j)->physicalPage * PageSize],
+				    PageSize);
+		copyTime = (HostTime() - start) * 1e6 / NumForks;
+
+		printf("Fork of %d pages, %d in memory: %.2f us, "
+			"copying them %.2f us\n", space->NumPages(), resident,
+			forkTime, copyTime);
+		delete space;
+	}
+}
+
 // Data structures needed for the console test.  Threads making
 // I/O requests wait on a Semaphore to delay until the I/O completes.
 
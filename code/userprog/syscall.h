@@ -31,6 +31,7 @@
 #define SC_Yield	10
 #define SC_Print  11
 #define SC_Mkdir  12
+#define SC_Sleep  13
 
 #ifndef IN_ASM
 
@@ -112,14 +113,14 @@ void Close(OpenFileId id);
 
 
 
-/* User-level thread operations: Fork and Yield.  To allow multiple
- * threads to run within a user program. 
- */
+/* Process and thread operations: Fork and Yield. */
 
-/* Fork a thread to run a procedure ("func") in the *same* address space 
- * as the current thread.
+/* Make a copy of this user program, in an address space of its own, 
+ * which runs alongside it.  Both return from Fork: the copy with 0, and 
+ * the original with the copy's address space identifier.  Pages are 
+ * shared copy-on-write, so only those written afterwards are copied.
  */
-void Fork(void (*func)());
+SpaceId Fork();
 
 /* Yield the CPU to another runnable thread, whether in this address space 
  * or not. 
@@ -128,6 +129,11 @@ void Yield();
 
 void Print(char* content, int numBytes);
 void Mkdir(char* path);
+
+/* Put the current thread to sleep for (at least) "ticks" of simulated
+ * time, without using the CPU meanwhile.
+ */
+void Sleep(int ticks);
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
@@ -0,0 +1,151 @@
+// pager.cc
+//	Routines to find frames for pages, evicting pages to swap when
+//	physical memory is full, and to move pages to and from swap.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pager.h"
+#include "system.h"
+#include "addrspace.h"
+
+//----------------------------------------------------------------------
+// Pager::Pager
+// 	Initialize the pager, and the swap disk, with nothing in swap.
+//
+//	"replacement" is the policy to evict pages by
+//----------------------------------------------------------------------
+
+Pager::Pager(ReplacementPolicy *replacement)
+{
+    ASSERT(PageSize == SectorSize);	// a page to a sector
+
+    policy = replacement;
+    lock = new Lock("pager");
+    swapDisk = new SynchDisk("SWAP");
+    swapMap = new BitMap(NumSectors);
+    swapRefs = new int[NumSectors];
+    numEvictions = 0;
+    swapTicks = 0;
+}
+
+//----------------------------------------------------------------------
+// Pager::~Pager
+// 	De-allocate the pager, and the swap disk.
+//----------------------------------------------------------------------
+
+Pager::~Pager()
+{
+    delete policy;
+    delete lock;
+    delete swapDisk;
+    delete swapMap;
+    delete [] swapRefs;
+}
+
+//----------------------------------------------------------------------
+// Pager::FindFrame
+// 	Find a frame for a page that is to be brought into memory.  If
+//	none is free, the replacement policy picks a page to evict, and
+//	its address space writes it to swap, if it must, and gives up
+//	the frame.  Called with the lock held.
+//
+//	"space" is the address space the page belongs to
+//	"virtualPage" is the page
+//----------------------------------------------------------------------
+
+int
+Pager::FindFrame(AddrSpace *space, int virtualPage)
+{
+    int frame, victim;
+
+#ifdef USE_TLB
+    tlbManager->SyncBits();		// the policy looks at use bits
+#endif
+    policy->Faulted();
+    frame = frameTable->Alloc(space, virtualPage);
+    if (frame >= 0)
+	return frame;
+
+    victim = policy->Victim();
+    DEBUG('a', "Evicting page %d from frame %d, for page %d\n",
+		frameTable->VirtualPage(victim), victim, virtualPage);
+    numEvictions++;
+    frameTable->Owner(victim)->PageOut(frameTable->VirtualPage(victim));
+    frame = frameTable->Alloc(space, virtualPage);
+    ASSERT(frame == victim);
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// Pager::AllocSwap, Pager::FreeSwap
+// 	Allocate and de-allocate a sector of swap, to keep a page in.
+//	A sector shared since a Fork is only de-allocated when the last
+//	address space with it frees it.
+//----------------------------------------------------------------------
+
+int
+Pager::AllocSwap()
+{
+    int sector = swapMap->Find();
+
+    ASSERT(sector >= 0);		// swap is full
+    swapRefs[sector] = 1;
+    return sector;
+}
+
+void
+Pager::FreeSwap(int sector)
+{
+    ASSERT(swapRefs[sector] > 0);
+    if (--swapRefs[sector] == 0)
+	swapMap->Clear(sector);
+}
+
+//----------------------------------------------------------------------
+// Pager::ReadSwap, Pager::WriteSwap
+// 	Copy a page between swap and a frame of physical memory, waiting
+//	until the disk is done.
+//
+//	"sector" is where the page is kept in swap
+//	"frame" is the frame it is in, or is to be in
+//----------------------------------------------------------------------
+
+void
+Pager::ReadSwap(int sector, int frame)
+{
+    int start = stats->totalTicks;
+
+    DEBUG('a', "Reading frame %d from swap sector %d\n", frame, sector);
+    swapDisk->ReadSector(sector, &(machine->mainMemory[frame * PageSize]));
+    stats->numPageIns++;
+    swapTicks += stats->totalTicks - start;
+}
+
+void
+Pager::WriteSwap(int sector, int frame)
+{
+    int start = stats->totalTicks;
+
+    DEBUG('a', "Writing frame %d to swap sector %d\n", frame, sector);
+    swapDisk->WriteSector(sector, &(machine->mainMemory[frame * PageSize]));
+    stats->numPageOuts++;
+    swapTicks += stats->totalTicks - start;
+}
+
+//----------------------------------------------------------------------
+// Pager::Print
+// 	Print the replacement policy, and how much paging it caused, so
+//	that policies can be compared on the same workload.
+//----------------------------------------------------------------------
+
+void
+Pager::Print()
+{
+    printf("Page replacement: %s, faults %d, evictions %d, page-ins %d, "
+	"page-outs %d, swap disk ticks %d\n", policy->Name(),
+	stats->numPageFaults, numEvictions, stats->numPageIns,
+	stats->numPageOuts, swapTicks);
+}
@@ -0,0 +1,72 @@
+// pager.h
+//	Data structures for virtual memory: a swap area for pages that
+//	don't fit in physical memory, and the pager, which finds frames
+//	for the page fault handler, evicting pages when memory is full.
+//
+//	Swap is a simulated disk of its own (the UNIX file "SWAP"), with
+//	one page to a sector, so paging doesn't disturb the file system,
+//	and costs real seeks and rotations.  An address space is given a
+//	swap sector for a page the first time the page is evicted dirty,
+//	and keeps it until it is deleted.  A clean page is just dropped:
+//	it is the same as its copy in swap, or, if it has none, as the
+//	executable (or zeroes), so it can be loaded again from there.
+//	After a Fork, parent and child share their swap sectors, as they
+//	do their frames, so a sector is counted as in use until the last
+//	of them frees it, and a shared sector is never written over.
+//
+//	Page faults are handled one at a time, under the pager's lock,
+//	since they wait for the disk, and a page being evicted or
+//	brought in must not be touched by anyone else meanwhile.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGER_H
+#define PAGER_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "bitmap.h"
+#include "synch.h"
+#include "synchdisk.h"
+#include "replacement.h"
+
+class AddrSpace;
+
+// The following class defines the pager.
+
+class Pager {
+  public:
+    Pager(ReplacementPolicy *replacement); // initialize, with swap empty
+    ~Pager();
+
+    void Acquire() { lock->Acquire(); }	// the page fault handler holds
+    void Release() { lock->Release(); }	// the lock throughout
+
+    int FindFrame(AddrSpace *space, int virtualPage); // a frame for
+					// "virtualPage" of "space", evicting
+					// some other page if need be
+    void Loaded(int frame) { policy->Loaded(frame); } // the page is in
+
+    int AllocSwap();			// a free swap sector
+    void ShareSwap(int sector) { swapRefs[sector]++; } // one more address
+					// space has the sector
+    void FreeSwap(int sector);		// one fewer; free once none do
+    int SwapSharers(int sector) { return swapRefs[sector]; }
+    void ReadSwap(int sector, int frame); // swap sector -> frame
+    void WriteSwap(int sector, int frame); // frame -> swap sector
+
+    void Print();			// print the policy and its counts
+
+  private:
+    ReplacementPolicy *policy;		// picks the pages to evict
+    Lock *lock;				// one page fault at a time
+    SynchDisk *swapDisk;		// where evicted pages go
+    BitMap *swapMap;			// bit set if the sector is in use
+    int *swapRefs;			// address spaces with each sector
+    int numEvictions;			// pages evicted, dirty or not
+    int swapTicks;			// time spent waiting for swapDisk
+};
+
+#endif // PAGER_H
@@ -0,0 +1,169 @@
+// replacement.cc
+//	Routines for the page replacement policies: picking a frame to
+//	evict when physical memory is full.
+//
+//	Victim is only called when every frame is in use, so each frame
+//	has an owner and a page table entry to look at.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "replacement.h"
+#include "system.h"
+#include "addrspace.h"
+
+//----------------------------------------------------------------------
+// NewReplacementPolicy
+// 	Return a new page replacement policy, given its name on the
+//	command line.
+//----------------------------------------------------------------------
+
+ReplacementPolicy *
+NewReplacementPolicy(char *name)
+{
+    if (!strcmp(name, "fifo"))
+	return new FifoReplacement;
+    if (!strcmp(name, "clock"))
+	return new ClockReplacement;
+    if (!strcmp(name, "eclock"))
+	return new EnhancedClockReplacement;
+    if (!strcmp(name, "aging"))
+	return new AgingReplacement;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ReplacementPolicy::FrameEntry
+// 	Return the page table entry of the page in a frame, or NULL if
+//	the frame is free.  A frame shared since a Fork goes by the entry
+//	of the first address space to have it, which is usually the
+//	parent, and most often the one using it.
+//
+//	"frame" is the frame number
+//----------------------------------------------------------------------
+
+TranslationEntry *
+ReplacementPolicy::FrameEntry(int frame)
+{
+    AddrSpace *space = frameTable->Owner(frame);
+
+    if (space == NULL)
+	return NULL;
+    return space->GetEntry(frameTable->VirtualPage(frame));
+}
+
+//----------------------------------------------------------------------
+// FifoReplacement
+//----------------------------------------------------------------------
+
+FifoReplacement::FifoReplacement()
+{
+    int i;
+
+    for (i = 0; i < NumPhysPages; i++)
+	loadedAt[i] = 0;
+    numLoaded = 0;
+}
+
+int
+FifoReplacement::Victim()
+{
+    int frame, oldest = 0;
+
+    for (frame = 1; frame < NumPhysPages; frame++)
+	if (loadedAt[frame] < loadedAt[oldest])
+	    oldest = frame;
+    return oldest;
+}
+
+//----------------------------------------------------------------------
+// ClockReplacement
+//	Every page gets a second chance, so the hand goes round at most
+//	once before it finds a victim.
+//----------------------------------------------------------------------
+
+int
+ClockReplacement::Victim()
+{
+    TranslationEntry *entry;
+    int frame;
+
+    for (;;) {
+	frame = hand;
+	hand = (hand + 1) % NumPhysPages;
+	entry = FrameEntry(frame);
+	if (!entry->use)
+	    return frame;
+	entry->use = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// EnhancedClockReplacement
+//	At most four times round: looking for (unused, clean), then for
+//	(unused, dirty) while clearing use bits, and then the same again,
+//	by which time every use bit is clear.
+//----------------------------------------------------------------------
+
+int
+EnhancedClockReplacement::Victim()
+{
+    TranslationEntry *entry;
+    int pass, i, frame;
+
+    for (pass = 0; pass < 4; pass++)
+	for (i = 0; i < NumPhysPages; i++) {
+	    frame = hand;
+	    hand = (hand + 1) % NumPhysPages;
+	    entry = FrameEntry(frame);
+	    if (!entry->use && (!entry->dirty || (pass & 1)))
+		return frame;
+	    if (pass & 1)
+		entry->use = FALSE;
+	}
+    ASSERT(FALSE);
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// AgingReplacement
+//	Counters are shifted at each page fault, rather than each clock
+//	tick, so they measure recency in faults: just what matters to
+//	which page the next fault should evict.
+//----------------------------------------------------------------------
+
+AgingReplacement::AgingReplacement()
+{
+    int i;
+
+    for (i = 0; i < NumPhysPages; i++)
+	age[i] = 0;
+}
+
+void
+AgingReplacement::Faulted()
+{
+    TranslationEntry *entry;
+    int frame;
+
+    for (frame = 0; frame < NumPhysPages; frame++) {
+	entry = FrameEntry(frame);
+	if (entry == NULL)
+	    continue;
+	age[frame] = (age[frame] >> 1) | (entry->use ? 0x80 : 0);
+	entry->use = FALSE;
+    }
+}
+
+int
+AgingReplacement::Victim()
+{
+    int frame, oldest = 0;
+
+    for (frame = 1; frame < NumPhysPages; frame++)
+	if (age[frame] < age[oldest])
+	    oldest = frame;
+    return oldest;
+}
@@ -0,0 +1,110 @@
+// replacement.h
+//	Page replacement policies.  When a page fault finds every frame
+//	of physical memory in use, the pager (see pager.h) asks the
+//	policy which frame to take back.  The policies go by the "use"
+//	and "dirty" bits the simulated hardware sets in each page's
+//	TranslationEntry; none of them sees individual references.
+//
+//	The policy is chosen when Nachos starts, with "-vm <name>":
+//	fifo, clock (second chance), eclock (enhanced clock, which
+//	prefers clean pages, since they needn't be written to swap)
+//	or aging (approximate LRU, by shifting the use bits into a
+//	counter for each frame).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef REPLACEMENT_H
+#define REPLACEMENT_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "machine.h"
+
+// The interface to a page replacement policy.  All the routines are
+// called with the pager's lock held.
+
+class ReplacementPolicy {
+  public:
+    virtual ~ReplacementPolicy() {}
+
+    virtual char *Name() = 0;
+    virtual void Faulted() {}		// a page fault is being handled
+    virtual void Loaded(int frame) {}	// a page was just brought into
+					// "frame"
+    virtual int Victim() = 0;		// the frame to evict; every frame
+					// is in use
+
+  protected:
+    TranslationEntry *FrameEntry(int frame); // the page table entry of
+					// the page in "frame"
+};
+
+ReplacementPolicy *NewReplacementPolicy(char *name); // NULL if "name"
+					// is not a policy
+
+// First in, first out: evict the page that has been in memory longest,
+// however much it is used.
+
+class FifoReplacement : public ReplacementPolicy {
+  public:
+    FifoReplacement();
+
+    char *Name() { return "fifo"; }
+    void Loaded(int frame) { loadedAt[frame] = numLoaded++; }
+    int Victim();
+
+  private:
+    int loadedAt[NumPhysPages];		// when each frame was loaded
+    int numLoaded;			// pages loaded so far
+};
+
+// Clock, or second chance: sweep a hand around the frames, clearing
+// use bits, and evict the first page whose use bit is already clear.
+
+class ClockReplacement : public ReplacementPolicy {
+  public:
+    ClockReplacement() { hand = 0; }
+
+    char *Name() { return "clock"; }
+    int Victim();
+
+  private:
+    int hand;				// the next frame to look at
+};
+
+// Enhanced clock: like clock, but by (use, dirty) class -- first a
+// page neither used nor dirty, then one dirty but not used (clearing
+// use bits on the way round), then the same again.
+
+class EnhancedClockReplacement : public ReplacementPolicy {
+  public:
+    EnhancedClockReplacement() { hand = 0; }
+
+    char *Name() { return "eclock"; }
+    int Victim();
+
+  private:
+    int hand;				// the next frame to look at
+};
+
+// Aging: at each page fault, shift every frame's counter right and put
+// its use bit in at the top, then clear the use bit.  The page with
+// the smallest counter is (roughly) the least recently used.
+
+class AgingReplacement : public ReplacementPolicy {
+  public:
+    AgingReplacement();
+
+    char *Name() { return "aging"; }
+    void Faulted();
+    void Loaded(int frame) { age[frame] = 0; }
+    int Victim();
+
+  private:
+    unsigned char age[NumPhysPages];	// recent use bits of each frame,
+					// most recent at the top
+};
+
+#endif // REPLACEMENT_H
@@ -0,0 +1,277 @@
+// tlbmanager.cc
+//	Routines to manage the software-loaded TLB: refilling it on a
+//	miss, handing out address space ids, and keeping the page tables'
+//	use and dirty bits up to date.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "tlbmanager.h"
+#include "system.h"
+#include "addrspace.h"
+
+#ifdef USE_TLB				// nothing to manage otherwise
+
+static char *replacementNames[] = { "random", "fifo", "lru" };
+
+//----------------------------------------------------------------------
+// TLBManager::TLBManager
+// 	Initialize the management of the TLB; it starts out empty, and
+//	no address space has an id.
+//
+//	"how" is how to pick the entry of a full set to replace
+//----------------------------------------------------------------------
+
+TLBManager::TLBManager(TLBReplacement how)
+{
+    int i;
+
+    replacement = how;
+    for (i = 0; i < NumAsids; i++)
+	asidOwner[i] = NULL;
+    nextAsid = 0;
+    loadedAt = new int[machine->tlbSize];
+    for (i = 0; i < machine->tlbSize; i++)
+	loadedAt[i] = 0;
+    numRefills = 0;
+    numAsidSteals = 0;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::~TLBManager
+// 	De-allocate the management of the TLB.
+//----------------------------------------------------------------------
+
+TLBManager::~TLBManager()
+{
+    delete [] loadedAt;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Refill
+// 	Handle a TLB miss, if we can: if the page is in memory, load its
+//	translation into the TLB, in the set the hardware will look in,
+//	and return TRUE.  The reference is tried again, and hits.
+//
+//	Returns FALSE if the page isn't in memory, or isn't in the
+//	address space at all; the page fault handler sorts that out.
+//
+//	"virtAddr" is the address whose translation was missing
+//----------------------------------------------------------------------
+
+bool
+TLBManager::Refill(int virtAddr)
+{
+    AddrSpace *space = currentThread->space;
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    TranslationEntry *pte, *entry;
+    int i;
+
+    if (vpn >= (unsigned) space->NumPages())
+	return FALSE;
+    pte = space->GetEntry(vpn);
+    if (!pte->valid)
+	return FALSE;
+
+    i = Choose(machine->TLBSet(vpn, machine->currentAsid));
+    Evict(i);
+    entry = &machine->tlb[i];
+    entry->virtualPage = vpn;
+    entry->physicalPage = pte->physicalPage;
+    entry->readOnly = pte->readOnly;
+    entry->use = FALSE;
+    entry->dirty = FALSE;
+    entry->asid = machine->currentAsid;
+    entry->valid = TRUE;
+    loadedAt[i] = numRefills++;
+    machine->tlbLastUse[i] = stats->numTLBHits;
+    DEBUG('a', "TLB entry %d now holds page %d of address space id %d\n",
+		i, vpn, entry->asid);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Choose
+// 	Pick an entry of a set to load a translation into: an invalid one
+//	if there is one, otherwise by the replacement policy.
+//
+//	"set" is the first entry of the set
+//----------------------------------------------------------------------
+
+int
+TLBManager::Choose(int set)
+{
+    TranslationEntry *tlb = machine->tlb;
+    int ways = machine->tlbWays;
+    int i, victim = set;
+
+    for (i = set; i < set + ways; i++)
+	if (!tlb[i].valid)
+	    return i;
+
+    switch (replacement) {
+      case TLBRandom:
+	return set + Random() % ways;
+      case TLBFifo:
+	for (i = set + 1; i < set + ways; i++)
+	    if (loadedAt[i] < loadedAt[victim])
+		victim = i;
+	return victim;
+      case TLBLru:
+	for (i = set + 1; i < set + ways; i++)
+	    if (machine->tlbLastUse[i] < machine->tlbLastUse[victim])
+		victim = i;
+	return victim;
+    }
+    ASSERT(FALSE);
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Evict
+// 	Take a translation out of the TLB, copying the use and dirty bits
+//	the hardware set in it back to the page table entry.
+//
+//	"i" is the TLB entry; nothing happens if it is invalid already
+//----------------------------------------------------------------------
+
+void
+TLBManager::Evict(int i)
+{
+    TranslationEntry *entry = &machine->tlb[i];
+    TranslationEntry *pte;
+
+    if (!entry->valid)
+	return;
+    pte = asidOwner[entry->asid]->GetEntry(entry->virtualPage);
+    pte->use = pte->use || entry->use;
+    pte->dirty = pte->dirty || entry->dirty;
+    entry->valid = FALSE;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Switch
+// 	An address space is about to run: make its id the current one.
+//	If it has none, give it the next one, taking it from whoever had
+//	it and flushing their entries -- so only when there are more
+//	than NumAsids address spaces does a switch cost any TLB misses.
+//
+//	"space" is the address space
+//----------------------------------------------------------------------
+
+void
+TLBManager::Switch(AddrSpace *space)
+{
+    int asid = space->GetAsid();
+    AddrSpace *owner;
+    int i;
+
+    if (asid < 0) {
+	asid = nextAsid;
+	nextAsid = (nextAsid + 1) % NumAsids;
+	owner = asidOwner[asid];
+	if (owner != NULL) {
+	    DEBUG('a', "Taking address space id %d for a new address space\n",
+			asid);
+	    for (i = 0; i < machine->tlbSize; i++)
+		if (machine->tlb[i].asid == asid)
+		    Evict(i);
+	    owner->SetAsid(-1);
+	    numAsidSteals++;
+	}
+	asidOwner[asid] = space;
+	space->SetAsid(asid);
+    }
+    machine->currentAsid = asid;
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Invalidate
+// 	A page's translation is about to change (it is being evicted,
+//	say): take it out of the TLB, so its use and dirty bits are back
+//	in the page table, and it isn't used any more.
+//
+//	"space" is the address space
+//	"virtualPage" is the page
+//----------------------------------------------------------------------
+
+void
+TLBManager::Invalidate(AddrSpace *space, int virtualPage)
+{
+    int asid = space->GetAsid();
+    int set, i;
+
+    if (asid < 0)
+	return;				// no entries at all
+    set = machine->TLBSet(virtualPage, asid);
+    for (i = set; i < set + machine->tlbWays; i++)
+	if (machine->tlb[i].valid && machine->tlb[i].asid == asid
+			&& machine->tlb[i].virtualPage == virtualPage)
+	    Evict(i);
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Forget
+// 	An address space is being deleted: drop its entries, without
+//	copying anything back, and give back its id.
+//
+//	"space" is the address space
+//----------------------------------------------------------------------
+
+void
+TLBManager::Forget(AddrSpace *space)
+{
+    int asid = space->GetAsid();
+    int i;
+
+    if (asid < 0)
+	return;
+    for (i = 0; i < machine->tlbSize; i++)
+	if (machine->tlb[i].asid == asid)
+	    machine->tlb[i].valid = FALSE;
+    asidOwner[asid] = NULL;
+    space->SetAsid(-1);
+}
+
+//----------------------------------------------------------------------
+// TLBManager::SyncBits
+// 	Copy the use and dirty bits of every valid entry back to the page
+//	tables, for the page replacement policy to look at.  The use bits
+//	in the TLB are cleared, so that clearing them in the page table
+//	means what it says.
+//----------------------------------------------------------------------
+
+void
+TLBManager::SyncBits()
+{
+    TranslationEntry *entry, *pte;
+    int i;
+
+    for (i = 0; i < machine->tlbSize; i++) {
+	entry = &machine->tlb[i];
+	if (!entry->valid)
+	    continue;
+	pte = asidOwner[entry->asid]->GetEntry(entry->virtualPage);
+	pte->use = pte->use || entry->use;
+	pte->dirty = pte->dirty || entry->dirty;
+	entry->use = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// TLBManager::Print
+// 	Print the shape of the TLB and how it was replaced; the hit rate
+//	is in the statistics.
+//----------------------------------------------------------------------
+
+void
+TLBManager::Print()
+{
+    printf("TLB: %d entries, %d-way, %s replacement, refills %d, "
+	"address space ids taken %d\n", machine->tlbSize, machine->tlbWays,
+	replacementNames[replacement], numRefills, numAsidSteals);
+}
+
+#endif // USE_TLB
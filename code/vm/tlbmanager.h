@@ -0,0 +1,74 @@
+// tlbmanager.h
+//	Data structures for managing the software-loaded TLB.
+//
+//	With a TLB (USE_TLB), the hardware only knows the translations
+//	the kernel has put in the TLB; any other reference is a page
+//	fault.  The page fault handler first tries Refill, which copies
+//	the translation from the address space's page table, if the page
+//	is in memory -- the common case, and a quick one.  Only if it
+//	isn't does the handler go on to bring the page in.
+//
+//	TLB entries are tagged with an address space id, so that a
+//	context switch doesn't flush the TLB: each address space keeps
+//	its entries until they are replaced.  There are only NumAsids
+//	ids, so when they run out, one is taken from another address
+//	space, and its entries flushed.
+//
+//	The hardware sets the use and dirty bits in the TLB entry, not
+//	the page table, so we copy them back when an entry is replaced,
+//	and whenever the pager is about to look at them.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TLBMANAGER_H
+#define TLBMANAGER_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "machine.h"
+
+class AddrSpace;
+
+// How to pick the entry of a set to replace, when it is full.
+
+enum TLBReplacement { TLBRandom,	// any of them
+		      TLBFifo,		// the one loaded longest ago
+		      TLBLru		// the one used longest ago
+};
+
+// The following class defines the kernel's management of the TLB.
+
+class TLBManager {
+  public:
+    TLBManager(TLBReplacement how);	// initialize, with the TLB empty
+    ~TLBManager();
+
+    bool Refill(int virtAddr);		// load the translation of "virtAddr"
+					// in the current address space;
+					// FALSE if its page isn't in memory
+    void Switch(AddrSpace *space);	// "space" is about to run
+    void Invalidate(AddrSpace *space, int virtualPage);
+					// the page's translation is changing
+    void Forget(AddrSpace *space);	// "space" is being deleted
+    void SyncBits();			// copy use and dirty bits back to
+					// the page tables
+
+    void Print();			// print how the TLB is set up,
+					// and how busy it has been
+
+  private:
+    TLBReplacement replacement;		// how to pick the entry to replace
+    AddrSpace *asidOwner[NumAsids];	// the address space with each id
+    int nextAsid;			// the next id to hand out
+    int *loadedAt;			// when each entry was loaded, for FIFO
+    int numRefills;			// entries loaded so far
+    int numAsidSteals;			// ids taken from other address spaces
+
+    int Choose(int set);		// the entry of "set" to replace
+    void Evict(int entry);		// copy back the entry's use and
+					// dirty bits, and invalidate it
+};
+
+#endif // TLBMANAGER_H